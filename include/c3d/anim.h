@@ -0,0 +1,66 @@
+#pragma once
+#include "maths.h"
+
+// Local transform of a bone relative to its parent
+typedef struct
+{
+	C3D_FQuat rot;
+	C3D_FVec trans;
+} C3D_BonePose;
+
+// Keyframes of one bone, sharing a time base for rotation and translation
+typedef struct
+{
+	const float* times;    // Ascending key times
+	const C3D_FQuat* rot;  // Rotation at each key (unit)
+	const C3D_FVec* trans; // Translation at each key
+	int numKeys;
+} C3D_BoneTrack;
+
+typedef struct
+{
+	const C3D_BoneTrack* tracks; // One per bone
+	int numBones;
+	float duration;
+} C3D_AnimClip;
+
+typedef struct
+{
+	const s16* parent;      // Parent of each bone, -1 for roots. Parents must come before their children.
+	const C3D_Mtx* invBind; // Inverse bind pose of each bone (affine)
+	int numBones;
+	const C3D_FDualQuat* invBindDual; // Optional inverse bind pose as dual quaternions, converted from invBind if NULL
+} C3D_Skeleton;
+
+// Sampling and blending interpolate rotations with Quat_Nlerp
+void Anim_SampleTrack(const C3D_BoneTrack* track, float time, C3D_BonePose* out);
+void Anim_SampleClip(const C3D_AnimClip* clip, float time, bool loop, C3D_BonePose* out);
+void Anim_LerpPoses(C3D_BonePose* out, const C3D_BonePose* a, const C3D_BonePose* b, float t, int numBones);
+
+// Weighted average of numPoses poses. Returns false and leaves out untouched if
+// there are no poses or the weights don't add up to more than zero.
+bool Anim_BlendPoses(C3D_BonePose* out, const C3D_BonePose* const* poses, const float* weights, int numPoses, int numBones);
+
+// Computes the model space transform of every bone into world, and writes the
+// skinning matrices (world * invBind) as three rows per bone into rows
+void Anim_ComputePalette(const C3D_Skeleton* skel, const C3D_BonePose* pose, C3D_Mtx* world, C3D_FVec* rows);
+
+// Same for dual quaternion skinning, two rows (real, dual) per bone. The
+// skeleton must be rigid: scale in the bind pose is dropped.
+void Anim_ComputeDualQuatPalette(const C3D_Skeleton* skel, const C3D_BonePose* pose, C3D_FDualQuat* world, C3D_FVec* rows);
+
+#ifdef _3DS
+#include "uniforms.h"
+
+// Writes the skinning palette straight into the float uniforms, 3x4 per bone starting at id
+static inline void Anim_UploadPalette(GPU_SHADER_TYPE type, int id, const C3D_Skeleton* skel, const C3D_BonePose* pose, C3D_Mtx* world)
+{
+	Anim_ComputePalette(skel, pose, world, C3D_FVUnifWritePtr(type, id, 3*skel->numBones));
+}
+
+// Writes the dual quaternion palette straight into the float uniforms, 2 per bone starting at id
+static inline void Anim_UploadDualQuatPalette(GPU_SHADER_TYPE type, int id, const C3D_Skeleton* skel, const C3D_BonePose* pose, C3D_FDualQuat* world)
+{
+	Anim_ComputeDualQuatPalette(skel, pose, world, C3D_FVUnifWritePtr(type, id, 2*skel->numBones));
+}
+#endif
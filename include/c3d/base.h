@@ -27,6 +27,8 @@ void C3D_DrawElements(GPU_Primitive_t primitive, int count, int type, const void
 // Immediate-mode vertex submission
 void C3D_ImmDrawBegin(GPU_Primitive_t primitive);
 void C3D_ImmSendAttrib(float x, float y, float z, float w);
+void C3D_ImmSendAttribs(const float* data, int count); // count x,y,z,w attributes
+void C3D_ImmSendVertices(const float* data, int numVerts, int attrsPerVert);
 void C3D_ImmDrawEnd(void);
 
 static inline void C3D_ImmDrawRestartPrim(void)
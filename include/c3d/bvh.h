@@ -0,0 +1,34 @@
+#pragma once
+#include "maths.h"
+
+#define C3D_BVH_MAX_DEPTH 64
+
+// 32-byte node. Nodes are stored depth first: an inner node is directly followed
+// by its first child, and 'index' points to its second child. Leaves reference
+// 'count' entries of the primitive index array starting at 'index'.
+typedef struct
+{
+	float min[3];
+	float max[3];
+	u32 index;
+	u32 count : 30; // 0 for inner nodes, leaves forced at C3D_BVH_MAX_DEPTH may exceed maxLeafSize
+	u32 axis  : 2;  // Split axis of inner nodes
+} C3D_BVHNode;
+
+typedef struct
+{
+	C3D_BVHNode* nodes;
+	u32* prims;
+	const C3D_AABB* bounds; // Primitive bounds the tree was built or last refit from
+	int numNodes;
+	int numPrims;
+} C3D_BVH;
+
+// Exact ray test for picking, returns the hit distance along dir or a negative value on a miss
+typedef float (*C3D_BVHRayFunc)(void* user, u32 prim, C3D_FVec origin, C3D_FVec dir);
+
+bool BVH_Build(C3D_BVH* bvh, const C3D_AABB* bounds, int count, int maxLeafSize);
+void BVH_Free(C3D_BVH* bvh);
+void BVH_Refit(C3D_BVH* bvh, const C3D_AABB* bounds);
+int  BVH_CullFrustum(const C3D_BVH* bvh, const C3D_Frustum* f, u32* visible);
+int  BVH_Raycast(const C3D_BVH* bvh, C3D_FVec origin, C3D_FVec dir, float maxDist, C3D_BVHRayFunc func, void* user, float* outDist);
@@ -0,0 +1,23 @@
+#pragma once
+#include "types.h"
+
+#define C3D_DYNRES_MAX_LEVELS 4
+
+typedef struct
+{
+	float budget;    // Target GPU time per frame, in milliseconds
+	float headroom;  // Fraction of the budget the next better level must fit in before switching back to it
+	float smoothing; // Weight of the newest sample in the running GPU time estimate, in (0,1]
+	int upDelay;     // Consecutive frames with enough headroom required before switching to a better level
+
+	int numLevels;
+	float cost[C3D_DYNRES_MAX_LEVELS]; // Relative GPU cost of each level, level 0 being the most expensive
+
+	int level;
+	int upCount;
+	float estimate;
+} C3D_DynRes;
+
+void DynRes_Init(C3D_DynRes* dr, float budget);
+void DynRes_SetLevels(C3D_DynRes* dr, const float* cost, int numLevels);
+int  DynRes_Update(C3D_DynRes* dr, float gpuTime);
@@ -0,0 +1,60 @@
+#pragma once
+#include "types.h"
+
+// Conversion of floats to the PICA200 float formats: f16 (s1e5m10), f24 (s1e7m16)
+// and f31 (s1e7m23). Mantissas are truncated as in libctru's f32tofXX, but where
+// those let out of range exponents wrap into the neighbouring fields, exponents
+// too small for the format give a signed zero and exponents too large saturate.
+
+static inline u32 C3Di_F32ToFloat(float f, int mantBits, int expBits, int bias)
+{
+	union { float f; u32 u; } v = { f };
+	u32 sign = v.u >> 31;
+	int exp = (int)((v.u >> 23) & 0xFF) - 127 + bias;
+	u32 mant = (v.u & 0x7FFFFF) >> (23 - mantBits);
+	int expMax = (1 << expBits) - 1;
+
+	if (!(v.u & 0x7FFFFFFF))
+		return 0;
+	if (exp < 0)
+		return sign << (mantBits + expBits);
+	if (exp > expMax)
+	{
+		exp = expMax;
+		mant = 0;
+	}
+	return (sign << (mantBits + expBits)) | ((u32)exp << mantBits) | mant;
+}
+
+// Inverse of C3Di_F32ToFloat, exponent 0 decodes to zero
+static inline float C3Di_FloatToF32(u32 v, int mantBits, int expBits, int bias)
+{
+	u32 sign = (v >> (mantBits + expBits)) & 1;
+	u32 exp = (v >> mantBits) & ((1 << expBits) - 1);
+	u32 mant = v & ((1 << mantBits) - 1);
+	union { u32 u; float f; } r;
+	r.u = sign << 31;
+	if (exp)
+		r.u |= ((exp - bias + 127) << 23) | (mant << (23 - mantBits));
+	return r.f;
+}
+
+static inline u32 C3D_F32ToF16(float f) { return C3Di_F32ToFloat(f, 10, 5, 15); }
+static inline u32 C3D_F32ToF24(float f) { return C3Di_F32ToFloat(f, 16, 7, 63); }
+static inline u32 C3D_F32ToF31(float f) { return C3Di_F32ToFloat(f, 23, 7, 63); }
+
+// Packs four f24 values into three words, in the word-reversed order the
+// GPUREG_FIXEDATTRIB_DATA registers expect (see C3D_ImmSendAttrib)
+static inline void C3D_PackF24x4(u32* out, u32 x, u32 y, u32 z, u32 w)
+{
+	out[0] = (z >> 16) | (w << 8);
+	out[1] = (y >> 8) | (z << 16);
+	out[2] = x | (y << 24);
+}
+
+void C3D_F32ToF16Array(u16* out, const float* in, int count);
+void C3D_F32ToF24Array(u32* out, const float* in, int count);
+void C3D_F32ToF31Array(u32* out, const float* in, int count);
+
+// Converts count x,y,z,w float vectors into 3 packed f24 words each
+void C3D_PackF24x4Array(u32* out, const float* in, int count);
@@ -0,0 +1,24 @@
+#pragma once
+#include "types.h"
+#include <math.h>
+
+typedef struct
+{
+	u32 data[128];
+} C3D_FogLut;
+
+static inline float FogLut_CalcZ(float depth, float near, float far)
+{
+	return far*near/(depth*(far-near)+near);
+}
+
+void FogLut_FromArray(C3D_FogLut* lut, const float data[256]);
+void FogLut_Exp(C3D_FogLut* lut, float density, float gradient, float near, float far);
+void FogLut_Exp2(C3D_FogLut* lut, float density, float near, float far);
+
+// Exponential fog that only starts to build up beyond the 'start' distance
+void FogLut_ExpRange(C3D_FogLut* lut, float density, float gradient, float start, float near, float far);
+
+// No fog up to 'start', full fog from 'end' on. An 'end' not beyond 'start'
+// gives a hard step at 'start'.
+void FogLut_Linear(C3D_FogLut* lut, float start, float end, float near, float far);
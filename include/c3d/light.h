@@ -1,5 +1,6 @@
 #pragma once
 #include "lightlut.h"
+#include "lightmodel.h"
 #include "maths.h"
 
 //-----------------------------------------------------------------------------
@@ -39,7 +40,15 @@ typedef struct
 
 enum
 {
-	C3DF_LightEnv_Dirty    = BIT(0),
+	// Register groups, each rewritten on its own
+	C3DF_LightEnv_AmbientDirty = BIT(0), // AMBIENT
+	C3DF_LightEnv_NumDirty     = BIT(3), // NUM_LIGHTS
+	C3DF_LightEnv_ConfigDirty  = BIT(4), // CONFIG0, CONFIG1
+	C3DF_LightEnv_InputDirty   = BIT(5), // LUTINPUT_ABS, SELECT, SCALE
+	C3DF_LightEnv_PermDirty    = BIT(6), // LIGHT_PERMUTATION
+	C3DF_LightEnv_Dirty        = C3DF_LightEnv_AmbientDirty | C3DF_LightEnv_NumDirty
+		| C3DF_LightEnv_ConfigDirty | C3DF_LightEnv_InputDirty | C3DF_LightEnv_PermDirty,
+
 	C3DF_LightEnv_MtlDirty = BIT(1),
 	C3DF_LightEnv_LCDirty  = BIT(2),
 
@@ -81,6 +90,31 @@ void C3D_LightEnvShadowMode(C3D_LightEnv* env, u32 mode);
 void C3D_LightEnvShadowSel(C3D_LightEnv* env, int texUnit);
 void C3D_LightEnvClampHighlights(C3D_LightEnv* env, bool clamp);
 
+typedef enum
+{
+	C3D_BRDF_GGX,
+	C3D_BRDF_BECKMANN,
+} C3D_BRDFDistribution;
+
+typedef struct
+{
+	C3D_LightLut dist;       // D1, indexed by N.H
+	C3D_LightLut fresnel[3]; // RR, RG, RB, indexed by V.H
+	float peak;              // Scale the distribution was normalized by
+	bool colored;            // Separate Fresnel curves for green and blue
+} C3D_LightEnvBRDF;
+
+// Cook-Torrance specular through specular1 = ks1 * D(N.H) * F(V.H) * G. Only
+// D1 and RR are used when f0 is gray, which fits the cheapest LUT layer; colored
+// f0 (metals) also needs RG and RB. G is the hardware geometric factor, enable it
+// with C3D_LightGeoFactor(light, 1, true). D0 is disabled, so specular0 should be
+// black, and specular1 should be scaled by 'peak' for absolute intensities.
+void C3D_LightEnvBRDFInit(C3D_LightEnvBRDF* brdf, C3D_BRDFDistribution dist, float roughness, const float f0[3]);
+void C3D_LightEnvCookTorrance(C3D_LightEnv* env, C3D_LightEnvBRDF* brdf);
+
+// Captures the register state the environment would program, for LightModel_Eval
+void C3D_LightEnvGetModel(C3D_LightEnv* env, C3D_LightModel* model);
+
 //-----------------------------------------------------------------------------
 // Light
 //-----------------------------------------------------------------------------
@@ -103,12 +137,20 @@ typedef struct
 enum
 {
 	C3DF_Light_Enabled  = BIT(0),
-	C3DF_Light_Dirty    = BIT(1),
 	C3DF_Light_MatDirty = BIT(2),
 	//C3DF_Light_Shadow   = BIT(3),
 	//C3DF_Light_Spot     = BIT(4),
 	//C3DF_Light_DistAttn = BIT(5),
 
+	// Register groups of C3D_LightConf, each rewritten on its own
+	C3DF_Light_ColorDirty  = BIT(1),  // SPECULAR0, SPECULAR1, DIFFUSE, AMBIENT
+	C3DF_Light_PosDirty    = BIT(6),  // XY, Z
+	C3DF_Light_SpotDirty   = BIT(7),  // SPOTDIR_XY, SPOTDIR_Z
+	C3DF_Light_ConfigDirty = BIT(8),  // CONFIG
+	C3DF_Light_AttnDirty   = BIT(9),  // ATTENUATION_BIAS, ATTENUATION_SCALE
+	C3DF_Light_Dirty       = C3DF_Light_ColorDirty | C3DF_Light_PosDirty
+		| C3DF_Light_SpotDirty | C3DF_Light_ConfigDirty | C3DF_Light_AttnDirty,
+
 	C3DF_Light_SPDirty  = BIT(14),
 	C3DF_Light_DADirty  = BIT(15),
 };
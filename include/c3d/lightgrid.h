@@ -0,0 +1,71 @@
+#pragma once
+#include "lightlut.h"
+#include "maths.h"
+
+typedef struct
+{
+	C3D_FVec pos;             // World space position, w is unused
+	float radius;             // No influence beyond this distance, 0 switches the light off
+	float color[3];           // r, g, b
+	C3D_LightLutDA* distAttn; // Optional distance attenuation
+} C3D_PointLight;
+
+// Spatial hash of an unbounded list of point lights, answering which of them
+// influence a box the most. C3D_LightMgr streams the chosen lights into
+// hardware light slots.
+typedef struct
+{
+	C3D_PointLight* lights;
+	u32* stamp;
+	int numLights, maxLights;
+	u32 curStamp;
+
+	float cellSize;
+	u32* bucketStart; // C3D_LIGHTGRID_BUCKETS+1 offsets into cellLights
+	u32* cellLights;
+	int numCellLights, maxCellLights;
+	u32* bigLights;   // Lights covering too many cells, tested for every query
+	int numBigLights;
+} C3D_LightGrid;
+
+#define C3D_LIGHTGRID_BUCKETS   256
+#define C3D_LIGHTGRID_MAX_CELLS 64 // Lights and boxes covering more cells bypass the grid
+
+bool LightGrid_Init(C3D_LightGrid* grid, float cellSize);
+void LightGrid_Free(C3D_LightGrid* grid);
+
+int  LightGrid_Add(C3D_LightGrid* grid, const C3D_PointLight* light);
+void LightGrid_Clear(C3D_LightGrid* grid);
+
+// Must be called after lights were added, moved or changed
+void LightGrid_Build(C3D_LightGrid* grid);
+
+// Luminance of the light weighted by a smooth falloff towards the edge of its
+// range, 0 if it doesn't reach the box
+float LightGrid_Score(const C3D_PointLight* light, const C3D_AABB* bounds);
+
+// Writes the ids of up to 'maxIds' (at most 8) lights with the highest scores
+// for the box, best first, and returns how many were found
+int  LightGrid_Query(C3D_LightGrid* grid, const C3D_AABB* bounds, int* ids, int maxIds);
+
+// Places 'count' lights into 'numSlots' slots holding the lights in slotLight
+// (-1 if empty). Lights already in a slot marked in slotValid keep it, the rest
+// replace lights that weren't picked, preferring empty slots. Updates slotLight,
+// sets *load to the slots that received a new light and returns the slots in use.
+u8 LightGrid_AssignSlots(int* slotLight, u8 slotValid, int numSlots, const int* ids, int count, u8* load);
+
+// Whether streaming the light into a hardware slot whose distance attenuation
+// table is 'slotDA' has to bind and upload the light's table
+static inline bool LightGrid_NeedsDATable(const C3D_LightLut* slotDA, const C3D_PointLight* light)
+{
+	return light->distAttn && &light->distAttn->lut != slotDA;
+}
+
+// Command buffer words C3D_LightMgr emits for the light block and table when
+// streaming the light into such a slot
+u32 LightGrid_LoadWords(const C3D_LightLut* slotDA, const C3D_PointLight* light);
+
+static inline C3D_PointLight* LightGrid_Get(C3D_LightGrid* grid, int id)
+{
+	return &grid->lights[id];
+}
@@ -5,6 +5,7 @@
 typedef struct
 {
 	u32 data[256];
+	u32 generation; // Changes whenever 'data' is rewritten, see LightLut_Changed
 } C3D_LightLut;
 
 typedef struct
@@ -26,10 +27,99 @@ static inline float spot_step(float angle, float cutoff)
 	return angle >= cutoff ? 1.0f : 0.0f;
 }
 
+static inline float spot_smoothstep(float angle, float cutoff)
+{
+	if (angle <= cutoff) return 0.0f;
+	if (angle >= 1.0f) return 1.0f;
+	float t = (angle - cutoff) / (1.0f - cutoff);
+	return t*t*(3.0f - 2.0f*t);
+}
+
+static inline float fresnel_schlick(float cosTheta, float f0)
+{
+	float m = 1.0f - cosTheta;
+	float m2 = m*m;
+	return f0 + (1.0f - f0)*(m2*m2*m);
+}
+
+// Microfacet distributions are scaled to a maximum of 1 since LUT entries can't
+// exceed 1, fold the peak (1/(pi*alpha^2) resp. beckmann_max(m)/(pi*m^2)) into
+// the specular color
+static inline float ggx_distribution(float nh, float alpha)
+{
+	if (nh <= 0.0f) return 0.0f;
+	float a2 = alpha*alpha;
+	float d = nh*nh*(a2 - 1.0f) + 1.0f;
+	return d > 0.0f ? (a2*a2)/(d*d) : 1.0f;
+}
+
+// Maximum of exp((c^2-1)/(m^2*c^2))/c^4 over N.H = c in [0,1]. It lies at N.H = 1
+// up to m^2 = 0.5, rougher surfaces peak at N.H = 1/sqrt(2*m^2)
+static inline float beckmann_max(float m)
+{
+	float m2 = m*m;
+	if (m2 <= 0.5f) return 1.0f;
+	return 4.0f*m2*m2*expf(1.0f/m2 - 2.0f);
+}
+
+static inline float beckmann_distribution(float nh, float m)
+{
+	if (nh <= 0.0f) return 0.0f;
+	if (nh >= 1.0f) return 1.0f / beckmann_max(m);
+	float c2 = nh*nh;
+	return expf((c2 - 1.0f)/(m*m*c2)) / (c2*c2*beckmann_max(m));
+}
+
+// Schlick's approximation of the Smith masking term for GGX (k = alpha/2)
+static inline float smith_ggx(float x, float alpha)
+{
+	if (x <= 0.0f) return 0.0f;
+	float k = 0.5f*alpha;
+	return x / (x*(1.0f - k) + k);
+}
+
+// Built-in LUT shapes, evaluated in bulk without going through a callback
+typedef enum
+{
+	C3D_LIGHTLUT_PHONG,       // powf(x, param)
+	C3D_LIGHTLUT_SPOT_STEP,   // spot_step(x, param)
+	C3D_LIGHTLUT_SPOT_SMOOTH, // spot_smoothstep(x, param)
+	C3D_LIGHTLUT_FRESNEL,     // fresnel_schlick(x, param), for GPU_LUTINPUT_VH or NV
+	C3D_LIGHTLUT_GGX,         // ggx_distribution(x, param), for GPU_LUTINPUT_NH
+	C3D_LIGHTLUT_BECKMANN,    // beckmann_distribution(x, param), for GPU_LUTINPUT_NH
+	C3D_LIGHTLUT_SMITH,       // smith_ggx(x, param), for GPU_LUTINPUT_NV or LN
+} C3D_LightLutShape;
+
+typedef struct
+{
+	C3D_LightLutShape shape;
+	float param;
+	bool negative;
+} C3D_LightLutDesc;
+
+#define C3D_LIGHTLUT_CACHE_SIZE 32
+
 void LightLut_FromArray(C3D_LightLut* lut, float* data);
+
+// Must be called after writing 'data' directly, so that a table already bound
+// to the GPU is uploaded again. The generators do this themselves.
+void LightLut_Changed(C3D_LightLut* lut);
 void LightLut_FromFunc(C3D_LightLut* lut, C3D_LightLutFunc func, float param, bool negative);
 void LightLutDA_Create(C3D_LightLutDA* lut, C3D_LightLutFuncDA func, float from, float to, float arg0, float arg1);
 
-#define LightLut_Phong(lut, shininess) LightLut_FromFunc((lut), powf, (shininess), false)
-#define LightLut_Spotlight(lut, angle) LightLut_FromFunc((lut), spot_step, cosf(angle), true)
-#define LightLutDA_Quadratic(lut, from, to, linear, quad) LightLutDA_Create((lut), quadratic_dist_attn, (from), (to), (linear), (quad))
+// Same tables as LightLut_FromFunc/LightLutDA_Create with the matching callback, bit for bit
+void LightLut_FromShape(C3D_LightLut* lut, C3D_LightLutShape shape, float param, bool negative);
+void LightLutDA_Quadratic(C3D_LightLutDA* lut, float from, float to, float linear, float quad);
+
+// Generates luts[i] from descs[i]. The raw 'data' arrays (1 KiB each, little
+// endian like the 3DS) can be stored as blobs and loaded into C3D_LightLut.
+void LightLut_FromShapes(C3D_LightLut* luts, const C3D_LightLutDesc* descs, int count);
+
+// Returns a shared table for the shape, generating it on first use. The table
+// must not be modified and stays valid until LightLut_CacheClear. Returns NULL
+// when the cache is full or out of memory.
+C3D_LightLut* LightLut_Cached(C3D_LightLutShape shape, float param, bool negative);
+void LightLut_CacheClear(void);
+
+#define LightLut_Phong(lut, shininess) LightLut_FromShape((lut), C3D_LIGHTLUT_PHONG, (shininess), false)
+#define LightLut_Spotlight(lut, angle) LightLut_FromShape((lut), C3D_LIGHTLUT_SPOT_STEP, cosf(angle), true)
@@ -0,0 +1,38 @@
+#pragma once
+#include "light.h"
+#include "lightgrid.h"
+
+// Picks the most influential point lights out of an unbounded list for each
+// object and streams them into a fixed set of hardware lights. Lights stay in
+// their slot as long as they are selected, so objects close to each other
+// mostly reuse the already loaded light blocks.
+typedef struct
+{
+	C3D_LightEnv* env;
+	C3D_Light hw[8];
+	int numHw;
+	int slotLight[8]; // Light loaded into each slot, -1 if none
+	u8 slotValid;     // Slots whose contents are up to date with the light list
+
+	C3D_LightGrid grid; // Rebuilt by LightMgr_Build
+	C3D_Mtx view;
+} C3D_LightMgr;
+
+// Takes 'perObject' free light slots of the environment
+bool LightMgr_Init(C3D_LightMgr* mgr, C3D_LightEnv* env, int perObject, float cellSize);
+void LightMgr_Free(C3D_LightMgr* mgr);
+
+int  LightMgr_Add(C3D_LightMgr* mgr, const C3D_PointLight* light);
+void LightMgr_Clear(C3D_LightMgr* mgr);
+
+// Must be called after lights were added, moved or changed and whenever the
+// view matrix changes, before selecting lights for the next object
+void LightMgr_Build(C3D_LightMgr* mgr, const C3D_Mtx* view);
+
+// Enables the most influential lights for an object, returns how many
+int  LightMgr_Select(C3D_LightMgr* mgr, const C3D_AABB* bounds);
+
+static inline C3D_PointLight* LightMgr_Get(C3D_LightMgr* mgr, int id)
+{
+	return LightGrid_Get(&mgr->grid, id);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "lightlut.h"
+
+// Snapshot of the fragment lighting registers of a light environment, in the
+// same encodings the GPU receives
+typedef struct
+{
+	u32 specular0, specular1, diffuse, ambient; // 10-bit fields, blue in the low bits, 255 = 1.0
+	u16 position[3];                            // float16
+	u16 spotDir[3];                             // Signed 1.11 fixed point
+	u32 config;
+	u32 distAttnBias, distAttnScale;            // float20
+	const C3D_LightLut* lutSP;
+	const C3D_LightLut* lutDA;
+} C3D_LightModelLight;
+
+typedef struct
+{
+	u32 ambient;
+	u32 numLights; // Minus one, as in GPUREG_LIGHTING_NUM_LIGHTS
+	u32 config[2];
+	u32 lutAbs, lutSelect, lutScale;
+	u32 permutation;
+	const C3D_LightLut* luts[8]; // Indexed by GPU_LIGHTLUTID, SP and DA are per light
+	C3D_LightModelLight lights[8];
+} C3D_LightModel;
+
+// Evaluates the lighting equation for count vertices, given eye space positions
+// and unit normals. Colors are written as 0xAABBGGRR with the Fresnel alpha if
+// enabled. With secondary NULL the specular color is added to the primary one.
+// Shadows, bump mapping and the CP LUT input need per-fragment data and are not
+// modeled (CP reads as 0).
+void LightModel_Eval(const C3D_LightModel* m, u32* primary, u32* secondary,
+	const float* px, const float* py, const float* pz,
+	const float* nx, const float* ny, const float* nz, int count);
@@ -369,6 +369,41 @@ void Mtx_Multiply(C3D_Mtx* out, const C3D_Mtx* a, const C3D_Mtx* b);
  */
 float Mtx_Inverse(C3D_Mtx* out);
 
+/**
+ * @brief Check whether a matrix is affine
+ * @param[in] m Matrix
+ * @return true if the bottom row of m is exactly 0,0,0,1
+ */
+static inline bool Mtx_IsAffine(const C3D_Mtx* m)
+{
+	return m->r[3].x == 0.0f && m->r[3].y == 0.0f && m->r[3].z == 0.0f && m->r[3].w == 1.0f;
+}
+
+/**
+ * @brief Multiply two affine matrices
+ * @param[out] out Output matrix
+ * @param[in]  a   Multiplicand
+ * @param[in]  b   Multiplier
+ * @note The bottom rows of a and b are assumed to be 0,0,0,1 and are not read.
+ */
+void Mtx_MultiplyAffine(C3D_Mtx* out, const C3D_Mtx* a, const C3D_Mtx* b);
+
+/**
+ * @brief Inverse an affine matrix
+ * @param[in,out] out Matrix to inverse
+ * @retval 0.0f Degenerate matrix (no inverse)
+ * @return determinant
+ * @note The bottom row of out is assumed to be 0,0,0,1 and is not read.
+ */
+float Mtx_InverseAffine(C3D_Mtx* out);
+
+/**
+ * @brief Inverse a rigid transform (orthonormal rotation and translation)
+ * @param[in,out] out Matrix to inverse
+ * @note No scale or shear may be present. Use Mtx_InverseAffine for those.
+ */
+void Mtx_InverseRigid(C3D_Mtx* out);
+
 /**
  * @brief Multiply 3x3 matrix by a FVec3
  * @param[in] mtx Matrix
@@ -398,6 +433,49 @@ static inline C3D_FVec Mtx_MultiplyFVecH(const C3D_Mtx* mtx, C3D_FVec v)
 	return Mtx_MultiplyFVec4(mtx, v);
 }
 
+/**
+ * @brief Multiply an array of FVec3 by a 3x3 matrix
+ * @param[in]  mtx   Matrix
+ * @param[out] out   Output array, may be the same as in
+ * @param[in]  in    Input array
+ * @param[in]  count Number of vectors
+ * @note Each output equals Mtx_MultiplyFVec3(mtx, in[i])
+ */
+void Mtx_MultiplyFVec3Array(const C3D_Mtx* mtx, C3D_FVec* out, const C3D_FVec* in, int count);
+
+/**
+ * @brief Multiply an array of FVec4 by a 4x4 matrix
+ * @param[in]  mtx   Matrix
+ * @param[out] out   Output array, may be the same as in
+ * @param[in]  in    Input array
+ * @param[in]  count Number of vectors
+ * @note Each output equals Mtx_MultiplyFVec4(mtx, in[i])
+ */
+void Mtx_MultiplyFVec4Array(const C3D_Mtx* mtx, C3D_FVec* out, const C3D_FVec* in, int count);
+
+/**
+ * @brief Transform packed 3D points by the affine part of a matrix
+ * @param[in]  mtx   Matrix, its bottom row is ignored
+ * @param[out] out   Output points (x,y,z triples), may be the same as in
+ * @param[in]  in    Input points (x,y,z triples)
+ * @param[in]  count Number of points
+ * @note Each output equals the xyz of Mtx_MultiplyFVecH(mtx, point)
+ */
+void Mtx_TransformPointsAffine(const C3D_Mtx* mtx, float* out, const float* in, int count);
+
+/**
+ * @brief Transform 3D points stored as separate coordinate arrays by the affine part of a matrix
+ * @param[in]  mtx   Matrix, its bottom row is ignored
+ * @param[out] outX  Output X coordinates, may be the same as inX
+ * @param[out] outY  Output Y coordinates, may be the same as inY
+ * @param[out] outZ  Output Z coordinates, may be the same as inZ
+ * @param[in]  inX   Input X coordinates
+ * @param[in]  inY   Input Y coordinates
+ * @param[in]  inZ   Input Z coordinates
+ * @param[in]  count Number of points
+ */
+void Mtx_TransformPointsAffineSoA(const C3D_Mtx* mtx, float* outX, float* outY, float* outZ, const float* inX, const float* inY, const float* inZ, int count);
+
 /**
  * @brief Get 4x4 matrix equivalent to Quaternion
  * @param[out] m Output matrix
@@ -579,6 +657,130 @@ void Mtx_PerspStereoTilt(C3D_Mtx* mtx, float fovy, float aspect, float near, flo
 void Mtx_LookAt(C3D_Mtx* out, C3D_FVec cameraPosition, C3D_FVec cameraTarget, C3D_FVec cameraUpVector, bool isLeftHanded);
 /** @} */
 
+/**
+ * @name Frustum Culling
+ * @{
+ */
+
+/**
+ * @brief Extract the clip planes of a projection matrix
+ * @note Works with the result of any of the projection functions, including the
+ *       tilted ones. Pass projection*view to get the planes in world space, or
+ *       projection*view*model to get them in model space.
+ * @param[out] out Output frustum
+ * @param[in]  mtx Matrix transforming into PICA clip space
+ */
+void Mtx_ExtractFrustum(C3D_Frustum* out, const C3D_Mtx* mtx);
+
+/**
+ * @brief Signed distance from a plane of a frustum
+ * @param[in] plane Frustum plane
+ * @param[in] p     Point
+ * @return Distance, positive on the inner side
+ */
+static inline float Frustum_PlaneDistance(C3D_FVec plane, C3D_FVec p)
+{
+	return plane.x*p.x + plane.y*p.y + plane.z*p.z + plane.w;
+}
+
+/**
+ * @brief Test a bounding sphere against a frustum
+ * @param[in] f Frustum
+ * @param[in] s Sphere, with its center in XYZ and radius in W
+ * @return Whether the sphere may be visible
+ */
+static inline bool Frustum_TestSphere(const C3D_Frustum* f, C3D_FVec s)
+{
+	for (int i = 0; i < 6; i ++)
+		if (Frustum_PlaneDistance(f->planes[i], s) < -s.w)
+			return false;
+	return true;
+}
+
+/**
+ * @brief Test an axis-aligned bounding box against a frustum
+ * @param[in] f   Frustum
+ * @param[in] box Bounding box
+ * @return Whether the box may be visible
+ */
+static inline bool Frustum_TestAABB(const C3D_Frustum* f, const C3D_AABB* box)
+{
+	C3D_FVec c = FVec3_Scale(FVec3_Add(box->min, box->max), 0.5f);
+	C3D_FVec e = FVec3_Scale(FVec3_Subtract(box->max, box->min), 0.5f);
+	for (int i = 0; i < 6; i ++)
+	{
+		C3D_FVec n = f->planes[i];
+		float r = fabsf(n.x)*e.x + fabsf(n.y)*e.y + fabsf(n.z)*e.z;
+		if (Frustum_PlaneDistance(n, c) < -r)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Cull an array of bounding spheres
+ * @note Indices are written in ascending order. Either list may be NULL.
+ * @param[in]  f       Frustum
+ * @param[in]  spheres Spheres, with their center in XYZ and radius in W
+ * @param[in]  count   Number of spheres
+ * @param[out] visible Indices of the spheres that may be visible
+ * @param[out] culled  Indices of the spheres outside the frustum
+ * @return Number of visible spheres
+ */
+int Frustum_CullSpheres(const C3D_Frustum* f, const C3D_FVec* spheres, int count, u32* visible, u32* culled);
+
+/**
+ * @brief Cull an array of axis-aligned bounding boxes
+ * @note Indices are written in ascending order. Either list may be NULL.
+ * @param[in]  f       Frustum
+ * @param[in]  boxes   Bounding boxes
+ * @param[in]  count   Number of boxes
+ * @param[out] visible Indices of the boxes that may be visible
+ * @param[out] culled  Indices of the boxes outside the frustum
+ * @return Number of visible boxes
+ */
+int Frustum_CullAABBs(const C3D_Frustum* f, const C3D_AABB* boxes, int count, u32* visible, u32* culled);
+
+/// Per-object visibility masks returned by the stereo culling functions
+enum
+{
+	C3D_STEREO_LEFT  = 1 << 0, ///< Visible to the left eye
+	C3D_STEREO_RIGHT = 1 << 1, ///< Visible to the right eye
+	C3D_STEREO_BOTH  = C3D_STEREO_LEFT | C3D_STEREO_RIGHT, ///< Visible to both eyes
+};
+
+/**
+ * @brief Extract the frusta of both eyes and a frustum containing both
+ * @note Pass the left and right eye matrices built with -iod and iod, e.g. by
+ *       @ref Mtx_PerspStereoTilt, multiplied by the view matrix. Planes common
+ *       to both eyes are only tested once by the stereo culling functions.
+ * @param[out] out   Output frusta
+ * @param[in]  left  Matrix transforming into the left eye's clip space
+ * @param[in]  right Matrix transforming into the right eye's clip space
+ */
+void Mtx_ExtractFrustumStereo(C3D_StereoFrustum* out, const C3D_Mtx* left, const C3D_Mtx* right);
+
+/**
+ * @brief Cull an array of bounding spheres for both eyes in one pass
+ * @param[in]  f       Stereo frusta
+ * @param[in]  spheres Spheres, with their center in XYZ and radius in W
+ * @param[in]  count   Number of spheres
+ * @param[out] masks   Visibility mask of each sphere (see C3D_STEREO_LEFT and C3D_STEREO_RIGHT)
+ * @return Number of spheres visible to at least one eye
+ */
+int Frustum_CullSpheresStereo(const C3D_StereoFrustum* f, const C3D_FVec* spheres, int count, u8* masks);
+
+/**
+ * @brief Cull an array of axis-aligned bounding boxes for both eyes in one pass
+ * @param[in]  f       Stereo frusta
+ * @param[in]  boxes   Bounding boxes
+ * @param[in]  count   Number of boxes
+ * @param[out] masks   Visibility mask of each box (see C3D_STEREO_LEFT and C3D_STEREO_RIGHT)
+ * @return Number of boxes visible to at least one eye
+ */
+int Frustum_CullAABBsStereo(const C3D_StereoFrustum* f, const C3D_AABB* boxes, int count, u8* masks);
+/** @} */
+
 /**
  * @name Quaternion Math
  * @{
@@ -787,5 +989,135 @@ C3D_FQuat Quat_LookAt(C3D_FVec source, C3D_FVec target, C3D_FVec forwardVector,
  * @return Quaternion rotation based on the axis and angle. Axis doesn't have to be orthogonal.
  */
 C3D_FQuat Quat_FromAxisAngle(C3D_FVec axis, float angle);
+
+/**
+ * @brief Normalized linear interpolation between two Quaternions
+ * @note Takes the shortest path. Faster than Quat_Slerp, but the angular
+ *       velocity is not constant over t.
+ * @param[in] a Start Quaternion (unit)
+ * @param[in] b End Quaternion (unit)
+ * @param[in] t Interpolation factor in [0,1]
+ * @return Interpolated unit Quaternion
+ */
+static inline C3D_FQuat Quat_Nlerp(C3D_FQuat a, C3D_FQuat b, float t)
+{
+	// q and -q are the same rotation, pick the one in a's hemisphere
+	float s = Quat_Dot(a, b) < 0.0f ? -t : t;
+	return Quat_Normalize(Quat_Add(Quat_Scale(a, 1.0f-t), Quat_Scale(b, s)));
+}
+
+/**
+ * @brief Spherical linear interpolation between two Quaternions
+ * @note Takes the shortest path at constant angular velocity.
+ * @param[in] a Start Quaternion (unit)
+ * @param[in] b End Quaternion (unit)
+ * @param[in] t Interpolation factor in [0,1]
+ * @return Interpolated unit Quaternion
+ */
+C3D_FQuat Quat_Slerp(C3D_FQuat a, C3D_FQuat b, float t);
+/** @} */
+
+/**
+ * @name Dual Quaternion Math
+ * @note Dual quaternions only represent rotation and translation. Scale and
+ *       shear are lost when converting from a matrix.
+ * @{
+ */
+
+/**
+ * @brief Dual Quaternion from a rotation and a translation
+ * @param[in] rot   Rotation (unit Quaternion)
+ * @param[in] trans Translation, applied after the rotation
+ * @return Dual Quaternion
+ */
+static inline C3D_FDualQuat DualQuat_FromRotTrans(C3D_FQuat rot, C3D_FVec trans)
+{
+	// dual = ½·t·rot, with t as a pure Quaternion
+	C3D_FDualQuat dq = { rot, Quat_Scale(Quat_Multiply(Quat_New(trans.x, trans.y, trans.z, 0.0f), rot), 0.5f) };
+	return dq;
+}
+
+/**
+ * @brief Identity Dual Quaternion
+ * @return Identity Dual Quaternion
+ */
+static inline C3D_FDualQuat DualQuat_Identity(void)
+{
+	C3D_FDualQuat dq = { Quat_Identity(), Quat_New(0.0f, 0.0f, 0.0f, 0.0f) };
+	return dq;
+}
+
+/**
+ * @brief Normalize a Dual Quaternion
+ * @param[in] dq Dual Quaternion to normalize
+ * @return Unit Dual Quaternion, with a unit real part orthogonal to the dual part
+ */
+static inline C3D_FDualQuat DualQuat_Normalize(C3D_FDualQuat dq)
+{
+	float s = 1.0f / FVec4_Magnitude(dq.real);
+	dq.real = Quat_Scale(dq.real, s);
+	dq.dual = Quat_Scale(dq.dual, s);
+
+	// Remove the part of dual along real, which does not affect the translation
+	dq.dual = Quat_Subtract(dq.dual, Quat_Scale(dq.real, Quat_Dot(dq.real, dq.dual)));
+	return dq;
+}
+
+/**
+ * @brief Translation of a Dual Quaternion
+ * @param[in] dq Unit Dual Quaternion
+ * @return Translation as FVec3
+ */
+static inline C3D_FVec DualQuat_Translation(C3D_FDualQuat dq)
+{
+	// t = 2·dual·real*
+	C3D_FQuat t = Quat_Multiply(dq.dual, Quat_Conjugate(dq.real));
+	return FVec3_New(2.0f*t.i, 2.0f*t.j, 2.0f*t.k);
+}
+
+/**
+ * @brief Transform a point by a Dual Quaternion
+ * @param[in] dq Unit Dual Quaternion
+ * @param[in] v  Point
+ * @return Rotated and translated point
+ */
+static inline C3D_FVec DualQuat_TransformFVec3(C3D_FDualQuat dq, C3D_FVec v)
+{
+	return FVec3_Add(Quat_CrossFVec3(dq.real, v), DualQuat_Translation(dq));
+}
+
+/**
+ * @brief Multiply two Dual Quaternions
+ * @param[in] lhs Multiplicand
+ * @param[in] rhs Multiplier
+ * @return lhs*rhs, which applies rhs first
+ */
+C3D_FDualQuat DualQuat_Multiply(C3D_FDualQuat lhs, C3D_FDualQuat rhs);
+
+/**
+ * @brief Get Dual Quaternion equivalent to the rigid part of a 4x4 matrix
+ * @note The rotation is extracted with Quat_FromMtx.
+ * @param[in] m Input Matrix
+ * @return Dual Quaternion
+ */
+C3D_FDualQuat DualQuat_FromMtx(const C3D_Mtx* m);
+
+/**
+ * @brief Get 4x4 matrix equivalent to a Dual Quaternion
+ * @param[out] m  Output matrix
+ * @param[in]  dq Input unit Dual Quaternion
+ */
+void Mtx_FromDualQuat(C3D_Mtx* m, C3D_FDualQuat dq);
+
+/**
+ * @brief Blend Dual Quaternions (dual quaternion linear blending)
+ * @note Inputs are flipped into the hemisphere of the first one before summing,
+ *       then the sum is normalized.
+ * @param[in] dq      Dual Quaternions to blend
+ * @param[in] weights Weight of each Dual Quaternion
+ * @param[in] count   Number of Dual Quaternions
+ * @return Blended unit Dual Quaternion
+ */
+C3D_FDualQuat DualQuat_Blend(const C3D_FDualQuat* dq, const float* weights, int count);
 /** @} */
 /** @} */
@@ -22,3 +22,57 @@ void MtxStack_Bind(C3D_MtxStack* stk, GPU_SHADER_TYPE unifType, int unifPos, int
 C3D_Mtx* MtxStack_Push(C3D_MtxStack* stk);
 C3D_Mtx* MtxStack_Pop(C3D_MtxStack* stk);
 void MtxStack_Update(C3D_MtxStack* stk);
+
+// Products cached by C3D_MvpStack, each of which can be bound to its own uniform range
+enum
+{
+	C3D_MVP_PROJECTION = 0, // projection
+	C3D_MVP_MODELVIEW,      // view * model
+	C3D_MVP_MVP,            // projection * view * model
+	C3D_MVP_NORMAL,         // inverse transpose of the model-view 3x3
+
+	C3D_MVP_COUNT,
+};
+
+enum
+{
+	C3D_MVPDIRTY_PROJ  = BIT(0),
+	C3D_MVPDIRTY_VIEW  = BIT(1),
+	C3D_MVPDIRTY_MODEL = BIT(2),
+	C3D_MVPDIRTY_ALL   = C3D_MVPDIRTY_PROJ | C3D_MVPDIRTY_VIEW | C3D_MVPDIRTY_MODEL,
+};
+
+typedef struct
+{
+	C3D_Mtx proj, view;
+	C3D_Mtx projView, modelView, mvp, normal;
+	C3D_Mtx* m; // Model matrix stack
+	int pos, depth;
+	u8 unifType[C3D_MVP_COUNT], unifPos[C3D_MVP_COUNT], unifLen[C3D_MVP_COUNT];
+	u8 dirty;
+} C3D_MvpStack;
+
+static inline C3D_Mtx* MvpStack_Projection(C3D_MvpStack* stk)
+{
+	stk->dirty |= C3D_MVPDIRTY_PROJ;
+	return &stk->proj;
+}
+
+static inline C3D_Mtx* MvpStack_View(C3D_MvpStack* stk)
+{
+	stk->dirty |= C3D_MVPDIRTY_VIEW;
+	return &stk->view;
+}
+
+static inline C3D_Mtx* MvpStack_Cur(C3D_MvpStack* stk)
+{
+	stk->dirty |= C3D_MVPDIRTY_MODEL;
+	return &stk->m[stk->pos];
+}
+
+bool MvpStack_Init(C3D_MvpStack* stk, int depth);
+void MvpStack_Free(C3D_MvpStack* stk);
+void MvpStack_Bind(C3D_MvpStack* stk, GPU_SHADER_TYPE unifType, int which, int unifPos, int unifLen);
+C3D_Mtx* MvpStack_Push(C3D_MvpStack* stk);
+C3D_Mtx* MvpStack_Pop(C3D_MvpStack* stk);
+void MvpStack_Update(C3D_MvpStack* stk);
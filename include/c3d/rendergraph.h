@@ -0,0 +1,58 @@
+#pragma once
+#include "renderqueue.h"
+#include "renderplan.h"
+
+typedef void (*C3D_RenderPassFunc)(void* user);
+
+typedef struct
+{
+	C3D_RenderTarget* target; // Imported target, or &own for transient resources
+	C3D_RenderTarget own;
+	C3D_Tex tex;
+	C3D_TexInitParams texParams;
+	s8 depthFmt; // GPU_DEPTHBUF, or -1 for none
+	bool transient;
+
+	C3D_ClearBits clearBits;
+	u32 clearColor, clearDepth;
+} C3D_RenderGraphRes;
+
+typedef struct
+{
+	C3D_RenderPassFunc func;
+	void* user;
+	u16 reads;
+	s8 target;
+} C3D_RenderPass;
+
+typedef struct
+{
+	C3D_RenderGraphRes res[C3D_RENDERGRAPH_MAX_RESOURCES];
+	C3D_RenderPass pass[C3D_RENDERGRAPH_MAX_PASSES];
+
+	C3D_RenderPlan plan;
+	void* slotMem[C3D_RENDERGRAPH_MAX_RESOURCES];
+
+	u8 numRes, numPasses, numSlotMem;
+	bool compiled;
+} C3D_RenderGraph;
+
+void C3D_RenderGraphInit(C3D_RenderGraph* rg);
+void C3D_RenderGraphFree(C3D_RenderGraph* rg);
+
+// Resources: targets owned by the user (e.g. screen targets) are imported and
+// their contents are kept, transient textures only live while the graph runs
+int C3D_RenderGraphImport(C3D_RenderGraph* rg, C3D_RenderTarget* target);
+int C3D_RenderGraphTransient(C3D_RenderGraph* rg, C3D_TexInitParams p, C3D_DEPTHTYPE depthFmt);
+void C3D_RenderGraphSetClear(C3D_RenderGraph* rg, int res, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth);
+C3D_Tex* C3D_RenderGraphTex(C3D_RenderGraph* rg, int res);
+C3D_RenderTarget* C3D_RenderGraphTarget(C3D_RenderGraph* rg, int res);
+
+// Passes draw on one resource and may sample any number of others
+int C3D_RenderGraphAddPass(C3D_RenderGraph* rg, int target, C3D_RenderPassFunc func, void* user);
+void C3D_RenderGraphPassReads(C3D_RenderGraph* rg, int pass, int res);
+
+// Imported targets drawing with the same depth buffer at compile time keep the
+// early depth buffer when the graph switches between them
+bool C3D_RenderGraphCompile(C3D_RenderGraph* rg);
+bool C3D_RenderGraphExecute(C3D_RenderGraph* rg);
@@ -0,0 +1,39 @@
+#pragma once
+#include "types.h"
+
+#define C3D_RENDERGRAPH_MAX_PASSES    16
+#define C3D_RENDERGRAPH_MAX_RESOURCES 16
+
+typedef struct
+{
+	u16 reads;  // Resources the pass samples
+	s8 target;  // Resource the pass draws on
+} C3D_RenderPlanPass;
+
+typedef struct
+{
+	u32 size;      // VRAM block needed by a transient resource, 0 for imported targets
+	s8 depthGroup; // Equal for targets drawing with the same depth buffer, -1 if none
+	u8 clearBits;  // C3D_ClearBits
+} C3D_RenderPlanRes;
+
+// Pass order, resource lifetimes and VRAM aliasing of a C3D_RenderGraph,
+// worked out from the pass and resource descriptions alone
+typedef struct
+{
+	u8 order[C3D_RENDERGRAPH_MAX_PASSES];
+	u16 clearAt[C3D_RENDERGRAPH_MAX_PASSES]; // Resources cleared right before the scheduled pass
+	u16 clearEarly;                          // Resources cleared when the graph starts
+	u16 keepEarlyDepth;                      // Scheduled passes switching target without clearing the early depth buffer
+
+	s8 first[C3D_RENDERGRAPH_MAX_RESOURCES]; // Lifetime in scheduled pass order, -1 if unused
+	s8 last[C3D_RENDERGRAPH_MAX_RESOURCES];
+	s8 slot[C3D_RENDERGRAPH_MAX_RESOURCES];  // VRAM block shared by transient resources, -1 if none
+	u32 slotSize[C3D_RENDERGRAPH_MAX_RESOURCES];
+
+	u8 numScheduled, numSlots;
+} C3D_RenderPlan;
+
+// Schedules the passes that contribute to an imported target and lets transient
+// resources whose lifetimes do not overlap share a VRAM block
+void RenderPlan_Build(C3D_RenderPlan* plan, const C3D_RenderPlanPass* passes, int numPasses, const C3D_RenderPlanRes* res, int numRes);
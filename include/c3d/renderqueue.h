@@ -1,5 +1,6 @@
 #pragma once
 #include "framebuffer.h"
+#include "dynres.h"
 
 typedef struct C3D_RenderTarget_tag C3D_RenderTarget;
 
@@ -15,18 +16,26 @@ struct C3D_RenderTarget_tag
 	gfxScreen_t screen;
 	gfx3dSide_t side;
 	C3D_ClearBits clearBits;
+	C3D_ClearBits overwritten, clearSkip;
 	u32 transferFlags;
 	u32 clearColor, clearDepth;
+
+	C3D_DynRes* dynRes;
+	u16 fullWidth, fullHeight;
+	u8 fullScaling;
 };
 
 // Flags for C3D_FrameBegin
 enum
 {
 	C3D_FRAME_SYNCDRAW = BIT(0), // Perform C3D_FrameSync before checking the GPU status
-	C3D_FRAME_NONBLOCK = BIT(1), // Return false instead of waiting if the GPU is busy
+	C3D_FRAME_NONBLOCK = BIT(1), // Return false instead of waiting if the GPU is busy, at any frame latency
 };
 
+#define C3D_MAX_FRAME_LATENCY 2
+
 float C3D_FrameRate(float fps);
+int C3D_FrameLatency(int n);
 void C3D_FrameSync(void);
 u32 C3D_FrameCounter(int id);
 
@@ -35,9 +44,50 @@ bool C3D_FrameDrawOn(C3D_RenderTarget* target);
 void C3D_FrameSplit(u8 flags);
 void C3D_FrameEnd(u8 flags);
 
+// Submits the work a frame deferred while the previous one was still running,
+// waiting for that one if needed. With a frame latency above 1, GX commands
+// issued directly inside a frame (GX_TextureCopy, GX_DisplayTransfer...) must
+// be preceded by this, or they overtake the frame's earlier command lists.
+void C3D_FrameFlushDeferred(void);
+
 float C3D_GetDrawingTime(void);
 float C3D_GetProcessingTime(void);
 
+// Per-frame timing record, all times in milliseconds
+typedef struct
+{
+	float cpuTime;  // Time spent between C3D_FrameBegin and C3D_FrameEnd
+	float gpuTime;  // Time the GPU took to execute the frame's command lists
+	float waitTime; // Time spent waiting for the previous frame, in C3D_FrameBegin or, with
+	                // a deferred wait, wherever the frame first submits (e.g. C3D_FrameSplit/End)
+	u32 cmdWords;   // Command buffer words used by the frame
+	u16 splits;     // Number of command lists submitted by the frame
+	u16 vblankMisses; // Frame periods missed since the previous frame began
+} C3D_FrameStats;
+
+typedef enum
+{
+	C3D_FRAMESTAT_CPU_TIME,
+	C3D_FRAMESTAT_GPU_TIME,
+	C3D_FRAMESTAT_WAIT_TIME,
+	C3D_FRAMESTAT_CMD_WORDS,
+	C3D_FRAMESTAT_SPLITS,
+	C3D_FRAMESTAT_VBLANK_MISSES,
+} C3D_FrameStatsField;
+
+typedef struct
+{
+	float min, avg, p95, p99, max;
+	int count;
+} C3D_FrameStatsSummary;
+
+bool C3D_FrameStatsEnable(int capacity);
+int C3D_FrameStatsCount(void);
+// Frames are recorded once the next frame has waited for them. Age 0 is the
+// latest one, returns false if fewer frames were recorded.
+bool C3D_FrameStatsGet(int age, C3D_FrameStats* out);
+bool C3D_FrameStatsQuery(C3D_FrameStatsField field, int window, C3D_FrameStatsSummary* out);
+
 #if defined(__GNUC__) && !defined(__cplusplus)
 typedef union __attribute__((__transparent_union__))
 {
@@ -63,7 +113,10 @@ C3D_RenderTarget* C3D_RenderTargetCreate(int width, int height, GPU_COLORBUF col
 C3D_RenderTarget* C3D_RenderTargetCreateFromTex(C3D_Tex* tex, GPU_TEXFACE face, int level, C3D_DEPTHTYPE depthFmt);
 void C3D_RenderTargetDelete(C3D_RenderTarget* target);
 void C3D_RenderTargetSetClear(C3D_RenderTarget* target, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth);
+// Marks buffers the current frame draws over entirely, skipping the clear after it
+void C3D_RenderTargetMarkOverwritten(C3D_RenderTarget* target, C3D_ClearBits bits);
 void C3D_RenderTargetSetOutput(C3D_RenderTarget* target, gfxScreen_t screen, gfx3dSide_t side, u32 transferFlags);
+void C3D_RenderTargetSetDynRes(C3D_RenderTarget* target, C3D_DynRes* dr);
 
 void C3D_SafeDisplayTransfer(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 flags);
 void C3D_SafeTextureCopy(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 size, u32 flags);
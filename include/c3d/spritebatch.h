@@ -0,0 +1,65 @@
+#pragma once
+#include "texture.h"
+#include "renderqueue.h"
+
+// Vertex layout written by the batcher. The bound shader program must take
+// v0 = position (float x3), v1 = texcoord (float x2), v2 = color (ubyte x4, 0..255).
+typedef struct
+{
+	float pos[3];
+	float uv[2];
+	u32 color;
+} C3D_SpriteVertex;
+
+typedef struct
+{
+	C3D_Tex* tex;         // NULL draws the tint color only
+	float x, y, depth;    // Position of the pivot
+	float width, height;
+	float pivotX, pivotY; // Pivot relative to the sprite size, (0,0) is the top left corner
+	float angle;          // Rotation about the pivot, in radians
+	float u0, v0, u1, v1; // Texture coordinates of the top left and bottom right corners
+	u32 color;            // Tint, 0xAABBGGRR
+	int layer;            // Layers are drawn in ascending order, sprites are sorted by texture within a layer
+} C3D_Sprite;
+
+typedef struct
+{
+	C3D_Sprite* sprites;
+	u32* order;
+	C3D_SpriteVertex* vtx; // C3D_MAX_FRAME_LATENCY+1 regions of linear memory, one per frame in flight
+	int maxSprites, numSprites;
+	int region;
+	u32 frame; // Frame of the last C3D_SpriteBatchEnd
+
+	// Statistics of the last C3D_SpriteBatchEnd
+	int lastDraws, lastSprites;
+} C3D_SpriteBatch;
+
+bool C3D_SpriteBatchInit(C3D_SpriteBatch* sb, int maxSprites);
+void C3D_SpriteBatchFree(C3D_SpriteBatch* sb);
+
+// A batch is begun and ended at most once per frame, ending it twice panics
+void C3D_SpriteBatchBegin(C3D_SpriteBatch* sb);
+bool C3D_SpriteBatchDraw(C3D_SpriteBatch* sb, const C3D_Sprite* sprite);
+
+// Draws the batch with the bound shader program. Unless the batch is empty this
+// reinitializes TexEnv stages 0-5, AttrInfo and BufInfo and binds the sprite
+// textures to unit 0; none of it is restored, so set them up again afterwards.
+void C3D_SpriteBatchEnd(C3D_SpriteBatch* sb);
+
+static inline void C3D_SpriteInit(C3D_Sprite* s, C3D_Tex* tex, float x, float y, float width, float height)
+{
+	s->tex = tex;
+	s->x = x;
+	s->y = y;
+	s->depth = 0.5f;
+	s->width = width;
+	s->height = height;
+	s->pivotX = s->pivotY = 0.0f;
+	s->angle = 0.0f;
+	s->u0 = 0.0f; s->v0 = 1.0f;
+	s->u1 = 1.0f; s->v1 = 0.0f;
+	s->color = 0xFFFFFFFF;
+	s->layer = 0;
+}
@@ -1,6 +1,12 @@
 #pragma once
 #include "types.h"
 
+#ifndef _3DS
+// Host builds of the combiner model lack libctru's register helpers
+#define GPU_TEVSOURCES(a,b,c) (((a))|((b)<<4)|((c)<<8))
+#define GPU_TEVOPERANDS(a,b,c) (((a))|((b)<<4)|((c)<<8))
+#endif
+
 typedef struct
 {
 	u16 srcRgb, srcAlpha;
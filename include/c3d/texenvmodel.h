@@ -0,0 +1,42 @@
+#pragma once
+#include "texenv.h"
+
+// Colors feeding the combiner for one fragment, as 0xAABBGGRR
+typedef struct
+{
+	u32 primary;       // Interpolated vertex color
+	u32 fragPrimary;   // Fragment lighting outputs
+	u32 fragSecondary;
+	u32 tex[4];        // Texture units 0-2, then the procedural texture
+} C3D_TexEnvInputs;
+
+// Snapshot of the combiner registers
+typedef struct
+{
+	C3D_TexEnv env[6];
+	u32 bufUpdate; // As in GPUREG_TEXENV_UPDATE_BUFFER, stage masks in bits 8-11 (RGB) and 12-15 (alpha)
+	u32 bufColor;
+} C3D_TexEnvModel;
+
+// Runs count fragments through the six stages with the integer arithmetic of
+// the GPU. A stage reads the combiner buffer as written up to the stage two
+// before it, stage 1 sees the buffer color and stage 0 reads black from both
+// GPU_PREVIOUS and GPU_PREVIOUS_BUFFER. GPU_DOT3_RGB(A) matches the hardware
+// to within a few steps, everything else exactly.
+void TexEnvModel_Eval(const C3D_TexEnvModel* m, u32* out, const C3D_TexEnvInputs* in, int count);
+
+// True if the stage hands its GPU_PREVIOUS input on unchanged
+bool TexEnv_IsPassthrough(const C3D_TexEnv* env);
+
+// Mask of the GPU_TEVSRC values the arguments taken by the stage's functions read
+u32 TexEnv_Sources(const C3D_TexEnv* env);
+
+// Rewrites six stages into an equivalent setup with as few non pass-through
+// stages as possible, all at the front. Arguments a function doesn't take are
+// cleared, stages computing a constant are folded into the next one, unread
+// stages are dropped and RGB-only and alpha-only neighbours are merged. Setups
+// reading GPU_PREVIOUS_BUFFER only get their unused arguments cleared.
+void TexEnv_Optimize(C3D_TexEnv* out, const C3D_TexEnv* in);
+
+// Copies the current combiner state of the context
+void C3D_TexEnvGetModel(C3D_TexEnvModel* model);
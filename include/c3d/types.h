@@ -5,7 +5,12 @@
 #include <stdbool.h>
 #include <stdint.h>
 typedef uint8_t u8;
+typedef int8_t s8;
+typedef uint16_t u16;
+typedef int16_t s16;
 typedef uint32_t u32;
+typedef int32_t s32;
+#define BIT(n) (1U<<(n))
 #endif
 
 #ifndef CITRO3D_NO_DEPRECATION
@@ -78,4 +83,50 @@ typedef union
 	C3D_FVec r[4]; ///< Rows are vectors
 	float m[4*4]; ///< Raw access
 } C3D_Mtx;
+
+/**
+ * @struct C3D_FDualQuat
+ * @brief Dual quaternion encoding a rigid transform
+ *
+ * The real part is the rotation, the dual part is half the translation
+ * times the rotation. Matches the layout of two consecutive float uniforms.
+ */
+typedef struct
+{
+	C3D_FQuat real; ///< Rotation
+	C3D_FQuat dual; ///< Translation part
+} C3D_FDualQuat;
+
+/**
+ * @struct C3D_AABB
+ * @brief Axis-aligned bounding box. The W components are unused.
+ */
+typedef struct
+{
+	C3D_FVec min; ///< Minimum corner
+	C3D_FVec max; ///< Maximum corner
+} C3D_AABB;
+
+/**
+ * @struct C3D_Frustum
+ * @brief View frustum as six inward-facing planes
+ *
+ * Each plane holds a unit normal in XYZ and its distance term in W, so that
+ * points p inside the frustum satisfy n∙p + w ≥ 0 for every plane.
+ */
+typedef struct
+{
+	C3D_FVec planes[6]; ///< -X, +X, -Y, +Y, near and far clip planes
+} C3D_Frustum;
+
+/**
+ * @struct C3D_StereoFrustum
+ * @brief Frusta of both eyes for stereoscopic culling
+ */
+typedef struct
+{
+	C3D_Frustum eye[2]; ///< Left and right eye frusta
+	C3D_Frustum both;   ///< Conservative frustum containing both eye frusta
+	u8 sharedPlanes;    ///< Bitmask of the planes that are the same for both eyes
+} C3D_StereoFrustum;
 /** @} */
@@ -50,6 +50,13 @@ static inline void C3D_FVUnifMtx2x4(GPU_SHADER_TYPE type, int id, const C3D_Mtx*
 	C3D_FVUnifMtxNx4(type, id, mtx, 2);
 }
 
+static inline void C3D_FVUnifDualQuat(GPU_SHADER_TYPE type, int id, const C3D_FDualQuat* dq)
+{
+	C3D_FVec* ptr = C3D_FVUnifWritePtr(type, id, 2);
+	ptr[0] = dq->real;
+	ptr[1] = dq->dual;
+}
+
 static inline void C3D_FVUnifSet(GPU_SHADER_TYPE type, int id, float x, float y, float z, float w)
 {
 	C3D_FVec* ptr = C3D_FVUnifWritePtr(type, id, 1);
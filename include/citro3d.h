@@ -11,23 +11,33 @@ extern "C" {
 #include "c3d/types.h"
 
 #include "c3d/maths.h"
+#include "c3d/bvh.h"
 #include "c3d/mtxstack.h"
 
 #include "c3d/uniforms.h"
+#include "c3d/floatpack.h"
+#include "c3d/anim.h"
 #include "c3d/attribs.h"
 #include "c3d/buffers.h"
 #include "c3d/base.h"
 
 #include "c3d/texenv.h"
+#include "c3d/texenvmodel.h"
 #include "c3d/effect.h"
 #include "c3d/texture.h"
 #include "c3d/proctex.h"
 #include "c3d/light.h"
 #include "c3d/lightlut.h"
+#include "c3d/lightmodel.h"
+#include "c3d/lightgrid.h"
+#include "c3d/lightmgr.h"
 #include "c3d/fog.h"
 
 #include "c3d/framebuffer.h"
+#include "c3d/dynres.h"
 #include "c3d/renderqueue.h"
+#include "c3d/rendergraph.h"
+#include "c3d/spritebatch.h"
 
 #ifdef __cplusplus
 }
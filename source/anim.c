@@ -0,0 +1,139 @@
+#include <c3d/anim.h>
+
+static inline C3D_FVec lerpFVec3(C3D_FVec a, C3D_FVec b, float t)
+{
+	return FVec3_Add(a, FVec3_Scale(FVec3_Subtract(b, a), t));
+}
+
+void Anim_SampleTrack(const C3D_BoneTrack* track, float time, C3D_BonePose* out)
+{
+	const float* times = track->times;
+	int n = track->numKeys;
+
+	if (n <= 1 || time <= times[0])
+	{
+		out->rot = track->rot[0];
+		out->trans = track->trans[0];
+		return;
+	}
+	if (time >= times[n-1])
+	{
+		out->rot = track->rot[n-1];
+		out->trans = track->trans[n-1];
+		return;
+	}
+
+	// Find the last key at or before time
+	int lo = 0, hi = n-1;
+	while (hi - lo > 1)
+	{
+		int mid = (lo + hi) / 2;
+		if (times[mid] <= time)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	float t = (time - times[lo]) / (times[hi] - times[lo]);
+	out->rot = Quat_Nlerp(track->rot[lo], track->rot[hi], t);
+	out->trans = lerpFVec3(track->trans[lo], track->trans[hi], t);
+}
+
+void Anim_SampleClip(const C3D_AnimClip* clip, float time, bool loop, C3D_BonePose* out)
+{
+	int i;
+	if (loop && clip->duration > 0.0f)
+	{
+		time = fmodf(time, clip->duration);
+		if (time < 0.0f)
+			time += clip->duration;
+	}
+
+	for (i = 0; i < clip->numBones; i ++)
+		Anim_SampleTrack(&clip->tracks[i], time, &out[i]);
+}
+
+void Anim_LerpPoses(C3D_BonePose* out, const C3D_BonePose* a, const C3D_BonePose* b, float t, int numBones)
+{
+	int i;
+	for (i = 0; i < numBones; i ++)
+	{
+		out[i].rot = Quat_Nlerp(a[i].rot, b[i].rot, t);
+		out[i].trans = lerpFVec3(a[i].trans, b[i].trans, t);
+	}
+}
+
+bool Anim_BlendPoses(C3D_BonePose* out, const C3D_BonePose* const* poses, const float* weights, int numPoses, int numBones)
+{
+	int i, j;
+	float total = 0.0f;
+	for (j = 0; j < numPoses; j ++)
+		total += weights[j];
+	if (numPoses <= 0 || total <= 0.0f)
+		return false;
+
+	float inv = 1.0f / total;
+	for (i = 0; i < numBones; i ++)
+	{
+		// Weighted quaternion sum, each input flipped into the first pose's hemisphere
+		C3D_FQuat first = poses[0][i].rot;
+		C3D_FQuat rot = Quat_New(0.0f, 0.0f, 0.0f, 0.0f);
+		C3D_FVec trans = FVec3_New(0.0f, 0.0f, 0.0f);
+		for (j = 0; j < numPoses; j ++)
+		{
+			const C3D_BonePose* p = &poses[j][i];
+			float w = weights[j] * inv;
+			rot = Quat_Add(rot, Quat_Scale(p->rot, Quat_Dot(first, p->rot) < 0.0f ? -w : w));
+			trans = FVec3_Add(trans, FVec3_Scale(p->trans, w));
+		}
+		// Negative weights can cancel the rotations out, keep the first one then
+		out[i].rot = Quat_Dot(rot, rot) > 1e-12f ? Quat_Normalize(rot) : first;
+		out[i].trans = trans;
+	}
+	return true;
+}
+
+void Anim_ComputePalette(const C3D_Skeleton* skel, const C3D_BonePose* pose, C3D_Mtx* world, C3D_FVec* rows)
+{
+	int i;
+	C3D_Mtx local, skin;
+	for (i = 0; i < skel->numBones; i ++)
+	{
+		Mtx_FromQuat(&local, pose[i].rot);
+		local.r[0].w = pose[i].trans.x;
+		local.r[1].w = pose[i].trans.y;
+		local.r[2].w = pose[i].trans.z;
+
+		int parent = skel->parent[i];
+		if (parent >= 0)
+			Mtx_MultiplyAffine(&world[i], &world[parent], &local);
+		else
+			Mtx_Copy(&world[i], &local);
+
+		// The bottom row is implied, so only three rows are written
+		Mtx_MultiplyAffine(&skin, &world[i], &skel->invBind[i]);
+		rows[3*i+0] = skin.r[0];
+		rows[3*i+1] = skin.r[1];
+		rows[3*i+2] = skin.r[2];
+	}
+}
+
+void Anim_ComputeDualQuatPalette(const C3D_Skeleton* skel, const C3D_BonePose* pose, C3D_FDualQuat* world, C3D_FVec* rows)
+{
+	int i;
+	for (i = 0; i < skel->numBones; i ++)
+	{
+		C3D_FDualQuat local = DualQuat_FromRotTrans(pose[i].rot, pose[i].trans);
+
+		int parent = skel->parent[i];
+		if (parent >= 0)
+			world[i] = DualQuat_Multiply(world[parent], local);
+		else
+			world[i] = local;
+
+		C3D_FDualQuat invBind = skel->invBindDual ? skel->invBindDual[i] : DualQuat_FromMtx(&skel->invBind[i]);
+		C3D_FDualQuat skin = DualQuat_Multiply(world[i], invBind);
+		rows[2*i+0] = skin.real;
+		rows[2*i+1] = skin.dual;
+	}
+}
@@ -57,6 +57,10 @@ static void C3Di_AptEventHook(APT_HookType hookType, C3D_UNUSED void* param)
 			C3Di_DirtyUniforms(GPU_GEOMETRY_SHADER);
 
 			ctx->fixedAttribDirty |= ctx->fixedAttribEverDirty;
+			memset(ctx->lightLuts, 0, sizeof(ctx->lightLuts));
+			ctx->lightHwValid = 0;
+			ctx->texEnvHwValid = 0;
+			ctx->fogLutHwValid = false;
 
 			C3D_LightEnv* env = ctx->lightEnv;
 			if (ctx->fogLut)
@@ -119,12 +123,16 @@ bool C3D_Init(size_t cmdBufSize)
 	ctx->texEnvBufClr = 0xFFFFFFFF;
 	ctx->fogClr = 0;
 	ctx->fogLut = NULL;
+	ctx->fogLutHwValid = false;
+	memset(ctx->lightLuts, 0, sizeof(ctx->lightLuts));
+	ctx->lightHwValid = 0;
 
 	for (i = 0; i < 3; i ++)
 		ctx->tex[i] = NULL;
 
 	for (i = 0; i < 6; i ++)
 		TexEnv_Init(&ctx->texEnv[i]);
+	ctx->texEnvHwValid = 0;
 
 	ctx->fixedAttribDirty = 0;
 	ctx->fixedAttribEverDirty = 0;
@@ -253,20 +261,13 @@ void C3Di_UpdateContext(void)
 	{
 		ctx->flags &= ~C3DiF_FogLut;
 		if (ctx->fogLut)
-		{
-			GPUCMD_AddWrite(GPUREG_FOG_LUT_INDEX, 0);
-			GPUCMD_AddWrites(GPUREG_FOG_LUT_DATA0, ctx->fogLut->data, 128);
-		}
+			C3Di_FogLutUpdate(ctx);
 	}
 
 	if (ctx->flags & C3DiF_TexEnvAll)
 	{
-		for (i = 0; i < 6; i ++)
-		{
-			if (!(ctx->flags & C3DiF_TexEnv(i))) continue;
-			C3Di_TexEnvBind(i, &ctx->texEnv[i]);
-		}
 		ctx->flags &= ~C3DiF_TexEnvAll;
+		C3Di_TexEnvUpdate(ctx);
 	}
 
 	C3D_LightEnv* env = ctx->lightEnv;
@@ -0,0 +1,394 @@
+#include <c3d/bvh.h>
+#include <float.h>
+#include <stdlib.h>
+
+#define SAH_BINS     16
+#define SAH_TRAVERSE 1.0f // Cost of visiting a node relative to testing a primitive
+
+typedef struct
+{
+	float min[3], max[3];
+} Box;
+
+typedef struct
+{
+	C3D_BVH* bvh;
+	float (*centroid)[3];
+	int maxLeafSize;
+} Builder;
+
+static inline void boxEmpty(Box* b)
+{
+	int i;
+	for (i = 0; i < 3; i ++)
+	{
+		b->min[i] = FLT_MAX;
+		b->max[i] = -FLT_MAX;
+	}
+}
+
+static inline void boxGrow(Box* b, const float* min, const float* max)
+{
+	int i;
+	for (i = 0; i < 3; i ++)
+	{
+		b->min[i] = fminf(b->min[i], min[i]);
+		b->max[i] = fmaxf(b->max[i], max[i]);
+	}
+}
+
+static inline float boxArea(const Box* b)
+{
+	float x = b->max[0]-b->min[0], y = b->max[1]-b->min[1], z = b->max[2]-b->min[2];
+	if (x < 0.0f) return 0.0f;
+	return x*y + y*z + z*x;
+}
+
+static inline void primBox(const C3D_AABB* a, float* min, float* max)
+{
+	min[0] = a->min.x; min[1] = a->min.y; min[2] = a->min.z;
+	max[0] = a->max.x; max[1] = a->max.y; max[2] = a->max.z;
+}
+
+static void leafBounds(const C3D_BVH* bvh, C3D_BVHNode* node)
+{
+	Box b;
+	u32 i;
+	boxEmpty(&b);
+	for (i = 0; i < node->count; i ++)
+	{
+		float min[3], max[3];
+		primBox(&bvh->bounds[bvh->prims[node->index+i]], min, max);
+		boxGrow(&b, min, max);
+	}
+	memcpy(node->min, b.min, sizeof(b.min));
+	memcpy(node->max, b.max, sizeof(b.max));
+}
+
+// Binned surface area heuristic over the centroids of prims [start,end)
+static bool findSplit(Builder* b, int start, int end, const Box* nodeBox, int* outAxis, float* outPos)
+{
+	struct { Box box; int count; } bins[SAH_BINS];
+	float leftArea[SAH_BINS], bestCost = FLT_MAX;
+	int leftCount[SAH_BINS];
+	int axis, i, count = end - start;
+	Box cb;
+
+	boxEmpty(&cb);
+	for (i = start; i < end; i ++)
+		boxGrow(&cb, b->centroid[b->bvh->prims[i]], b->centroid[b->bvh->prims[i]]);
+
+	for (axis = 0; axis < 3; axis ++)
+	{
+		float lo = cb.min[axis], extent = cb.max[axis] - lo;
+		if (extent <= 0.0f) continue;
+
+		for (i = 0; i < SAH_BINS; i ++)
+		{
+			boxEmpty(&bins[i].box);
+			bins[i].count = 0;
+		}
+		for (i = start; i < end; i ++)
+		{
+			u32 p = b->bvh->prims[i];
+			int bin = (int)((b->centroid[p][axis] - lo) * SAH_BINS / extent);
+			if (bin >= SAH_BINS) bin = SAH_BINS-1;
+			float min[3], max[3];
+			primBox(&b->bvh->bounds[p], min, max);
+			boxGrow(&bins[bin].box, min, max);
+			bins[bin].count ++;
+		}
+
+		Box acc;
+		int n = 0;
+		boxEmpty(&acc);
+		for (i = 0; i < SAH_BINS-1; i ++)
+		{
+			boxGrow(&acc, bins[i].box.min, bins[i].box.max);
+			n += bins[i].count;
+			leftArea[i] = boxArea(&acc);
+			leftCount[i] = n;
+		}
+
+		boxEmpty(&acc);
+		n = 0;
+		for (i = SAH_BINS-1; i > 0; i --)
+		{
+			boxGrow(&acc, bins[i].box.min, bins[i].box.max);
+			n += bins[i].count;
+			if (!leftCount[i-1] || !n) continue;
+			float cost = leftArea[i-1]*leftCount[i-1] + boxArea(&acc)*n;
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				*outAxis = axis;
+				*outPos = lo + extent*i/SAH_BINS;
+			}
+		}
+	}
+
+	if (bestCost == FLT_MAX)
+		return false;
+
+	// Only split if it beats testing every primitive of this node
+	float area = boxArea(nodeBox);
+	return count > b->maxLeafSize || area <= 0.0f || SAH_TRAVERSE + bestCost/area < count;
+}
+
+static int buildNode(Builder* b, int start, int end, int depth)
+{
+	C3D_BVH* bvh = b->bvh;
+	int id = bvh->numNodes++;
+	C3D_BVHNode* node = &bvh->nodes[id];
+	int i, mid, axis = 0, count = end - start;
+	float pos = 0.0f;
+
+	node->index = start;
+	node->count = count;
+	node->axis = 0;
+	leafBounds(bvh, node);
+
+	if (count <= 1 || depth >= C3D_BVH_MAX_DEPTH-1)
+		return id;
+
+	Box nodeBox;
+	memcpy(nodeBox.min, node->min, sizeof(nodeBox.min));
+	memcpy(nodeBox.max, node->max, sizeof(nodeBox.max));
+
+	if (findSplit(b, start, end, &nodeBox, &axis, &pos))
+	{
+		for (i = mid = start; i < end; i ++)
+		{
+			u32 p = bvh->prims[i];
+			if (b->centroid[p][axis] < pos)
+			{
+				bvh->prims[i] = bvh->prims[mid];
+				bvh->prims[mid++] = p;
+			}
+		}
+	} else if (count > b->maxLeafSize)
+		mid = start + count/2; // All centroids coincide, any split is as good
+	else
+		return id;
+
+	if (mid == start || mid == end)
+		mid = start + count/2;
+
+	node->count = 0;
+	node->axis = axis;
+	buildNode(b, start, mid, depth+1);
+	bvh->nodes[id].index = buildNode(b, mid, end, depth+1);
+	return id;
+}
+
+bool BVH_Build(C3D_BVH* bvh, const C3D_AABB* bounds, int count, int maxLeafSize)
+{
+	int i;
+	Builder b;
+
+	memset(bvh, 0, sizeof(*bvh));
+	if (count <= 0 || count >= (1 << 30)) return false;
+	if (maxLeafSize < 1) maxLeafSize = 1;
+
+	bvh->nodes = (C3D_BVHNode*)malloc((2*count-1)*sizeof(C3D_BVHNode));
+	bvh->prims = (u32*)malloc(count*sizeof(u32));
+	b.centroid = malloc(count*sizeof(*b.centroid));
+	if (!bvh->nodes || !bvh->prims || !b.centroid)
+	{
+		free(b.centroid);
+		BVH_Free(bvh);
+		return false;
+	}
+
+	bvh->bounds = bounds;
+	bvh->numPrims = count;
+	for (i = 0; i < count; i ++)
+	{
+		bvh->prims[i] = i;
+		b.centroid[i][0] = (bounds[i].min.x + bounds[i].max.x)*0.5f;
+		b.centroid[i][1] = (bounds[i].min.y + bounds[i].max.y)*0.5f;
+		b.centroid[i][2] = (bounds[i].min.z + bounds[i].max.z)*0.5f;
+	}
+
+	b.bvh = bvh;
+	b.maxLeafSize = maxLeafSize;
+	buildNode(&b, 0, count, 0);
+	free(b.centroid);
+	return true;
+}
+
+void BVH_Free(C3D_BVH* bvh)
+{
+	free(bvh->nodes);
+	free(bvh->prims);
+	memset(bvh, 0, sizeof(*bvh));
+}
+
+void BVH_Refit(C3D_BVH* bvh, const C3D_AABB* bounds)
+{
+	int i, j;
+	bvh->bounds = bounds;
+
+	// Children always come after their parent
+	for (i = bvh->numNodes-1; i >= 0; i --)
+	{
+		C3D_BVHNode* node = &bvh->nodes[i];
+		if (node->count)
+		{
+			leafBounds(bvh, node);
+			continue;
+		}
+
+		const C3D_BVHNode* l = &bvh->nodes[i+1];
+		const C3D_BVHNode* r = &bvh->nodes[node->index];
+		for (j = 0; j < 3; j ++)
+		{
+			node->min[j] = fminf(l->min[j], r->min[j]);
+			node->max[j] = fmaxf(l->max[j], r->max[j]);
+		}
+	}
+}
+
+// Returns the planes the box still straddles, or -1 if it is outside one of them
+static int classifyBox(const C3D_Frustum* f, int planes, const float* min, const float* max)
+{
+	int i;
+	float cx = (min[0]+max[0])*0.5f, cy = (min[1]+max[1])*0.5f, cz = (min[2]+max[2])*0.5f;
+	float ex = (max[0]-min[0])*0.5f, ey = (max[1]-min[1])*0.5f, ez = (max[2]-min[2])*0.5f;
+	for (i = 0; i < 6; i ++)
+	{
+		if (!(planes & (1 << i))) continue;
+		C3D_FVec n = f->planes[i];
+		float r = fabsf(n.x)*ex + fabsf(n.y)*ey + fabsf(n.z)*ez;
+		float d = n.x*cx + n.y*cy + n.z*cz + n.w;
+		if (d < -r)
+			return -1;
+		if (d >= r)
+			planes &= ~(1 << i);
+	}
+	return planes;
+}
+
+int BVH_CullFrustum(const C3D_BVH* bvh, const C3D_Frustum* f, u32* visible)
+{
+	struct { u32 node; int planes; } stack[C3D_BVH_MAX_DEPTH];
+	int sp = 0, numVisible = 0;
+	u32 i;
+
+	if (!bvh->numNodes) return 0;
+	stack[sp].node = 0;
+	stack[sp++].planes = 0x3F;
+
+	while (sp)
+	{
+		sp --;
+		const C3D_BVHNode* node = &bvh->nodes[stack[sp].node];
+		int planes = classifyBox(f, stack[sp].planes, node->min, node->max);
+		if (planes < 0)
+			continue;
+
+		if (!planes)
+		{
+			// Entirely inside: the whole subtree is visible, and its primitives are
+			// contiguous in the index array since the nodes are stored depth first
+			const C3D_BVHNode* last = node;
+			while (!last->count)
+				last = &bvh->nodes[last->index];
+			const C3D_BVHNode* first = node;
+			while (!first->count)
+				first = first + 1;
+			for (i = first->index; i < last->index + last->count; i ++)
+				visible[numVisible++] = bvh->prims[i];
+			continue;
+		}
+
+		if (node->count)
+		{
+			for (i = 0; i < node->count; i ++)
+			{
+				u32 p = bvh->prims[node->index+i];
+				float min[3], max[3];
+				primBox(&bvh->bounds[p], min, max);
+				if (classifyBox(f, planes, min, max) >= 0)
+					visible[numVisible++] = p;
+			}
+			continue;
+		}
+
+		stack[sp].node = node->index;
+		stack[sp++].planes = planes;
+		stack[sp].node = node - bvh->nodes + 1;
+		stack[sp++].planes = planes;
+	}
+
+	return numVisible;
+}
+
+static inline float rayBox(const float* min, const float* max, const float* o, const float* inv, float maxDist)
+{
+	int i;
+	float tmin = 0.0f, tmax = maxDist;
+	for (i = 0; i < 3; i ++)
+	{
+		float t0 = (min[i] - o[i]) * inv[i];
+		float t1 = (max[i] - o[i]) * inv[i];
+		if (t0 > t1) { float t = t0; t0 = t1; t1 = t; }
+		tmin = fmaxf(tmin, t0); // fmaxf discards the NaN of a zero direction component in the slab
+		tmax = fminf(tmax, t1);
+	}
+	return tmin <= tmax ? tmin : -1.0f;
+}
+
+int BVH_Raycast(const C3D_BVH* bvh, C3D_FVec origin, C3D_FVec dir, float maxDist, C3D_BVHRayFunc func, void* user, float* outDist)
+{
+	u32 stack[C3D_BVH_MAX_DEPTH];
+	int sp = 0, hit = -1;
+	u32 i;
+	float o[3] = { origin.x, origin.y, origin.z };
+	float inv[3] = { 1.0f/dir.x, 1.0f/dir.y, 1.0f/dir.z };
+	float best = maxDist;
+
+	if (!bvh->numNodes) return -1;
+	stack[sp++] = 0;
+
+	while (sp)
+	{
+		const C3D_BVHNode* node = &bvh->nodes[stack[--sp]];
+		if (rayBox(node->min, node->max, o, inv, best) < 0.0f)
+			continue;
+
+		if (node->count)
+		{
+			for (i = 0; i < node->count; i ++)
+			{
+				u32 p = bvh->prims[node->index+i];
+				float min[3], max[3], t;
+				primBox(&bvh->bounds[p], min, max);
+				t = rayBox(min, max, o, inv, best);
+				if (t >= 0.0f && func)
+					t = func(user, p, origin, dir);
+				if (t >= 0.0f && t <= best)
+				{
+					best = t;
+					hit = p;
+				}
+			}
+			continue;
+		}
+
+		// Visit the child on the near side of the split first
+		u32 nearChild = node - bvh->nodes + 1, farChild = node->index;
+		if (inv[node->axis] < 0.0f)
+		{
+			u32 t = nearChild;
+			nearChild = farChild;
+			farChild = t;
+		}
+		stack[sp++] = farChild;
+		stack[sp++] = nearChild;
+	}
+
+	if (hit >= 0 && outDist)
+		*outDist = best;
+	return hit;
+}
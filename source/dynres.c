@@ -0,0 +1,65 @@
+#include <c3d/dynres.h>
+
+void DynRes_Init(C3D_DynRes* dr, float budget)
+{
+	dr->budget = budget;
+	dr->headroom = 0.8f;
+	dr->smoothing = 0.5f;
+	dr->upDelay = 30;
+	dr->numLevels = 1;
+	dr->cost[0] = 1.0f;
+	dr->level = 0;
+	dr->upCount = 0;
+	dr->estimate = 0.0f;
+}
+
+void DynRes_SetLevels(C3D_DynRes* dr, const float* cost, int numLevels)
+{
+	int i;
+	if (numLevels < 1) numLevels = 1;
+	if (numLevels > C3D_DYNRES_MAX_LEVELS) numLevels = C3D_DYNRES_MAX_LEVELS;
+	for (i = 0; i < numLevels; i ++)
+		dr->cost[i] = cost[i];
+	dr->numLevels = numLevels;
+	if (dr->level >= numLevels)
+		dr->level = numLevels-1;
+	dr->upCount = 0;
+}
+
+int DynRes_Update(C3D_DynRes* dr, float gpuTime)
+{
+	int level = dr->level;
+
+	if (dr->estimate <= 0.0f)
+		dr->estimate = gpuTime;
+	else
+		dr->estimate += dr->smoothing*(gpuTime - dr->estimate);
+
+	// Estimated GPU time of a level with relative cost 1
+	float unit = dr->estimate / dr->cost[level];
+
+	if (dr->estimate > dr->budget)
+	{
+		// Over budget: immediately drop to the best level predicted to fit
+		while (level < dr->numLevels-1 && unit*dr->cost[level] > dr->budget)
+			level ++;
+		dr->upCount = 0;
+	} else if (level > 0 && unit*dr->cost[level-1] <= dr->budget*dr->headroom)
+	{
+		// Comfortably under budget: go back up one level once this has held for a while
+		if (++dr->upCount >= dr->upDelay)
+		{
+			level --;
+			dr->upCount = 0;
+		}
+	} else
+		dr->upCount = 0;
+
+	if (level != dr->level)
+	{
+		dr->estimate = unit*dr->cost[level];
+		dr->level = level;
+	}
+
+	return level;
+}
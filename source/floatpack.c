@@ -0,0 +1,81 @@
+#include <c3d/floatpack.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+// Four conversions at once, following C3Di_F32ToFloat bit for bit
+static inline __m128i C3Di_F32ToFloat4(__m128 f, int mantBits, int expBits, int bias)
+{
+	__m128i v = _mm_castps_si128(f);
+	__m128i zero = _mm_setzero_si128();
+	__m128i sign = _mm_sll_epi32(_mm_srli_epi32(v, 31), _mm_cvtsi32_si128(mantBits + expBits));
+	__m128i exp = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(v, 23), _mm_set1_epi32(0xFF)), _mm_set1_epi32(127 - bias));
+	__m128i mant = _mm_srl_epi32(_mm_and_si128(v, _mm_set1_epi32(0x7FFFFF)), _mm_cvtsi32_si128(23 - mantBits));
+	__m128i expMax = _mm_set1_epi32((1 << expBits) - 1);
+
+	__m128i over = _mm_cmpgt_epi32(exp, expMax);
+	exp = _mm_or_si128(_mm_andnot_si128(over, exp), _mm_and_si128(over, expMax));
+	mant = _mm_andnot_si128(over, mant);
+
+	__m128i r = _mm_or_si128(sign, _mm_or_si128(_mm_sll_epi32(exp, _mm_cvtsi32_si128(mantBits)), mant));
+	__m128i under = _mm_cmplt_epi32(exp, zero);
+	r = _mm_or_si128(_mm_andnot_si128(under, r), _mm_and_si128(under, sign));
+
+	__m128i isZero = _mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32(0x7FFFFFFF)), zero);
+	return _mm_andnot_si128(isZero, r);
+}
+#endif
+
+void C3D_F32ToF16Array(u16* out, const float* in, int count)
+{
+	int i = 0;
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4)
+	{
+		u32 tmp[4];
+		_mm_storeu_si128((__m128i*)tmp, C3Di_F32ToFloat4(_mm_loadu_ps(in+i), 10, 5, 15));
+		out[i+0] = tmp[0];
+		out[i+1] = tmp[1];
+		out[i+2] = tmp[2];
+		out[i+3] = tmp[3];
+	}
+#endif
+	for (; i < count; i ++)
+		out[i] = C3D_F32ToF16(in[i]);
+}
+
+void C3D_F32ToF24Array(u32* out, const float* in, int count)
+{
+	int i = 0;
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128((__m128i*)(out+i), C3Di_F32ToFloat4(_mm_loadu_ps(in+i), 16, 7, 63));
+#endif
+	for (; i < count; i ++)
+		out[i] = C3D_F32ToF24(in[i]);
+}
+
+void C3D_F32ToF31Array(u32* out, const float* in, int count)
+{
+	int i = 0;
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128((__m128i*)(out+i), C3Di_F32ToFloat4(_mm_loadu_ps(in+i), 23, 7, 63));
+#endif
+	for (; i < count; i ++)
+		out[i] = C3D_F32ToF31(in[i]);
+}
+
+void C3D_PackF24x4Array(u32* out, const float* in, int count)
+{
+	int i;
+	for (i = 0; i < count; i ++, in += 4, out += 3)
+	{
+#if defined(__SSE2__)
+		u32 f[4];
+		_mm_storeu_si128((__m128i*)f, C3Di_F32ToFloat4(_mm_loadu_ps(in), 16, 7, 63));
+		C3D_PackF24x4(out, f[0], f[1], f[2], f[3]);
+#else
+		C3D_PackF24x4(out, C3D_F32ToF24(in[0]), C3D_F32ToF24(in[1]), C3D_F32ToF24(in[2]), C3D_F32ToF24(in[3]));
+#endif
+	}
+}
@@ -1,46 +1,28 @@
 #include "internal.h"
 
-void FogLut_FromArray(C3D_FogLut* lut, const float data[256])
+void C3Di_FogLutUpdate(C3D_Context* ctx)
 {
-	int i;
-	for (i = 0; i < 128; i ++)
-	{
-		float in = data[i], diff = data[i+128];
-
-		u32 val = 0;
-		if (in > 0.0f)
-		{
-			in *= 0x800;
-			val = (in < 0x800) ? (u32)in : 0x7FF;
-		}
+	int i, start, gap;
+	const u32* data = ctx->fogLut->data;
+	u32* hw = ctx->fogLutHw;
 
-		u32 val2 = 0;
-		if (diff != 0.0f)
+	// Only runs of entries that differ from what the GPU holds are sent, gaps
+	// shorter than a new run's index write and header are sent along
+	for (i = 0; i < 128;)
+	{
+		if (ctx->fogLutHwValid && data[i] == hw[i])
 		{
-			diff *= 0x800;
-			if (diff < -0x1000) diff = -0x1000;
-			else if (diff > 0xFFF) diff = 0xFFF;
-			val2 = (s32)diff & 0x1FFF;
+			i ++;
+			continue;
 		}
-
-		lut->data[i] = val2 | (val << 13);
+		for (start = i, gap = 0; i < 128 && gap < 4; i ++)
+			gap = (ctx->fogLutHwValid && data[i] == hw[i]) ? gap+1 : 0;
+		GPUCMD_AddWrite(GPUREG_FOG_LUT_INDEX, start);
+		GPUCMD_AddWrites(GPUREG_FOG_LUT_DATA0, &data[start], i-gap-start);
 	}
-}
 
-void FogLut_Exp(C3D_FogLut* lut, float density, float gradient, float near, float far)
-{
-	int i;
-	float data[256];
-	for (i = 0; i <= 128; i ++)
-	{
-		float x = FogLut_CalcZ(i/128.0f, near, far);
-		float val = expf(-powf(density*x, gradient));
-		if (i < 128)
-			data[i] = val;
-		if (i > 0)
-			data[i+127] = val-data[i-1];
-	}
-	FogLut_FromArray(lut, data);
+	memcpy(hw, data, sizeof(ctx->fogLutHw));
+	ctx->fogLutHwValid = true;
 }
 
 void C3D_FogGasMode(GPU_FOGMODE fogMode, GPU_GASMODE gasMode, bool zFlip)
@@ -73,10 +55,9 @@ void C3D_FogLutBind(C3D_FogLut* lut)
 	if (!(ctx->flags & C3DiF_Active))
 		return;
 
+	ctx->fogLut = lut;
 	if (lut)
-	{
 		ctx->flags |= C3DiF_FogLut;
-		ctx->fogLut = lut;
-	} else
+	else
 		ctx->flags &= ~C3DiF_FogLut;
 }
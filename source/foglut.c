@@ -0,0 +1,100 @@
+#include <c3d/foglut.h>
+
+void FogLut_FromArray(C3D_FogLut* lut, const float data[256])
+{
+	int i;
+	for (i = 0; i < 128; i ++)
+	{
+		float in = data[i], diff = data[i+128];
+
+		u32 val = 0;
+		if (in > 0.0f)
+		{
+			in *= 0x800;
+			val = (in < 0x800) ? (u32)in : 0x7FF;
+		}
+
+		u32 val2 = 0;
+		if (diff != 0.0f)
+		{
+			diff *= 0x800;
+			if (diff < -0x1000) diff = -0x1000;
+			else if (diff > 0xFFF) diff = 0xFFF;
+			val2 = (s32)diff & 0x1FFF;
+		}
+
+		lut->data[i] = val2 | (val << 13);
+	}
+}
+
+// Depths of the 129 samples a LUT is built from, i/128 between the planes
+static void C3Di_FogLutDepths(float* z, float near, float far)
+{
+	int i;
+	for (i = 0; i <= 128; i ++)
+		z[i] = FogLut_CalcZ(i/128.0f, near, far);
+}
+
+static void C3Di_FogLutFromSamples(C3D_FogLut* lut, const float* y)
+{
+	int i;
+	float data[256];
+	for (i = 0; i < 128; i ++)
+	{
+		data[i]     = y[i];
+		data[i+128] = y[i+1]-y[i];
+	}
+	FogLut_FromArray(lut, data);
+}
+
+void FogLut_Exp(C3D_FogLut* lut, float density, float gradient, float near, float far)
+{
+	FogLut_ExpRange(lut, density, gradient, 0.0f, near, far);
+}
+
+void FogLut_Exp2(C3D_FogLut* lut, float density, float near, float far)
+{
+	FogLut_ExpRange(lut, density, 2.0f, 0.0f, near, far);
+}
+
+void FogLut_ExpRange(C3D_FogLut* lut, float density, float gradient, float start, float near, float far)
+{
+	int i;
+	float z[129], y[129];
+	C3Di_FogLutDepths(z, near, far);
+	for (i = 0; i <= 128; i ++)
+		z[i] = z[i] > start ? density*(z[i]-start) : 0.0f;
+
+	// The common gradients don't need powf
+	if (gradient == 1.0f)
+		for (i = 0; i <= 128; i ++)
+			y[i] = expf(-z[i]);
+	else if (gradient == 2.0f)
+		for (i = 0; i <= 128; i ++)
+			y[i] = expf(-z[i]*z[i]);
+	else
+		for (i = 0; i <= 128; i ++)
+			y[i] = expf(-powf(z[i], gradient));
+	C3Di_FogLutFromSamples(lut, y);
+}
+
+void FogLut_Linear(C3D_FogLut* lut, float start, float end, float near, float far)
+{
+	int i;
+	float z[129], y[129];
+	C3Di_FogLutDepths(z, near, far);
+	if (end <= start)
+	{
+		for (i = 0; i <= 128; i ++)
+			y[i] = z[i] < start ? 1.0f : 0.0f;
+	} else
+	{
+		float scale = 1.0f / (end-start);
+		for (i = 0; i <= 128; i ++)
+		{
+			float f = (end-z[i])*scale;
+			y[i] = f < 0.0f ? 0.0f : f > 1.0f ? 1.0f : f;
+		}
+	}
+	C3Di_FogLutFromSamples(lut, y);
+}
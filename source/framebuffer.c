@@ -1,4 +1,5 @@
 #include "internal.h"
+#include <c3d/renderqueue.h>
 
 static const u8 colorFmtSizes[] = {2,1,0,0,0};
 static const u8 depthFmtSizes[] = {0,0,1,2};
@@ -68,33 +69,64 @@ void C3Di_FrameBufBind(C3D_FrameBuf* fb)
 	GPUCMD_AddIncrementalWrites(GPUREG_COLORBUFFER_READ, param, 4);
 }
 
-void C3D_FrameBufClear(C3D_FrameBuf* frameBuf, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth)
+int C3Di_FrameBufFills(C3D_FrameBuf* frameBuf, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth, C3Di_MemFill* out)
 {
+	int n = 0;
 	u32 size = (u32)frameBuf->width * frameBuf->height;
 	u32 cfs = colorFmtSizes[frameBuf->colorFmt];
 	u32 dfs = depthFmtSizes[frameBuf->depthFmt];
-	void* colorBufEnd = (u8*)frameBuf->colorBuf + size*(2+cfs);
-	void* depthBufEnd = (u8*)frameBuf->depthBuf + size*(2+dfs);
 
-	if (clearBits & C3D_CLEAR_COLOR)
+	if ((clearBits & C3D_CLEAR_COLOR) && frameBuf->colorBuf)
+	{
+		out[n].start   = (u32*)frameBuf->colorBuf;
+		out[n].end     = (u32*)((u8*)frameBuf->colorBuf + size*(2+cfs));
+		out[n].value   = clearColor;
+		out[n].control = BIT(0) | (cfs << 8);
+		n ++;
+	}
+	if ((clearBits & C3D_CLEAR_DEPTH) && frameBuf->depthBuf)
 	{
-		if (clearBits & C3D_CLEAR_DEPTH)
-			GX_MemoryFill(
-				(u32*)frameBuf->colorBuf, clearColor, (u32*)colorBufEnd, BIT(0) | (cfs << 8),
-				(u32*)frameBuf->depthBuf, clearDepth, (u32*)depthBufEnd, BIT(0) | (dfs << 8));
-		else
-			GX_MemoryFill(
-				(u32*)frameBuf->colorBuf, clearColor, (u32*)colorBufEnd, BIT(0) | (cfs << 8),
-				NULL, 0, NULL, 0);
-	} else
+		out[n].start   = (u32*)frameBuf->depthBuf;
+		out[n].end     = (u32*)((u8*)frameBuf->depthBuf + size*(2+dfs));
+		out[n].value   = clearDepth;
+		out[n].control = BIT(0) | (dfs << 8);
+		n ++;
+	}
+	return n;
+}
+
+void C3Di_MemFillSubmit(const C3Di_MemFill* fills, int count)
+{
+	// Each GX_MemoryFill command has two independent fill units
+	for (; count >= 2; count -= 2, fills += 2)
+		GX_MemoryFill(
+			fills[0].start, fills[0].value, fills[0].end, fills[0].control,
+			fills[1].start, fills[1].value, fills[1].end, fills[1].control);
+	if (count)
 		GX_MemoryFill(
-			(u32*)frameBuf->depthBuf, clearDepth, (u32*)depthBufEnd, BIT(0) | (dfs << 8),
+			fills[0].start, fills[0].value, fills[0].end, fills[0].control,
 			NULL, 0, NULL, 0);
 }
 
-void C3D_FrameBufTransfer(C3D_FrameBuf* frameBuf, gfxScreen_t screen, gfx3dSide_t side, u32 transferFlags)
+void C3D_FrameBufClear(C3D_FrameBuf* frameBuf, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth)
+{
+	C3Di_MemFill fills[2];
+	int n = C3Di_FrameBufFills(frameBuf, clearBits, clearColor, clearDepth, fills);
+
+	// Inside a frame the clear has to stay in order with what was recorded so far
+	if (!C3Di_FrameMemFill(fills, n))
+		C3Di_MemFillSubmit(fills, n);
+}
+
+void C3Di_FrameBufTransfer(C3D_FrameBuf* frameBuf, gfxScreen_t screen, gfx3dSide_t side, u32 transferFlags)
 {
 	u32* outputFrameBuf = (u32*)gfxGetFramebuffer(screen, side, NULL, NULL);
 	u32 dim = GX_BUFFER_DIM((u32)frameBuf->width, (u32)frameBuf->height);
 	GX_DisplayTransfer((u32*)frameBuf->colorBuf, dim, outputFrameBuf, dim, transferFlags);
 }
+
+void C3D_FrameBufTransfer(C3D_FrameBuf* frameBuf, gfxScreen_t screen, gfx3dSide_t side, u32 transferFlags)
+{
+	C3D_FrameFlushDeferred();
+	C3Di_FrameBufTransfer(frameBuf, screen, side, transferFlags);
+}
@@ -1,4 +1,5 @@
 #include "internal.h"
+#include <c3d/floatpack.h>
 
 void C3D_ImmDrawBegin(GPU_Primitive_t primitive)
 {
@@ -18,40 +19,55 @@ void C3D_ImmDrawBegin(GPU_Primitive_t primitive)
 	GPUCMD_AddWrite(GPUREG_FIXEDATTRIB_INDEX, 0xF);
 }
 
-static inline void write24(u8* p, u32 val)
+void C3D_ImmSendAttrib(float x, float y, float z, float w)
 {
-	p[0] = val;
-	p[1] = val>>8;
-	p[2] = val>>16;
+	u32 param[3];
+
+	// Convert the values to float24 and pack them into reversed words
+	C3D_PackF24x4(param, C3D_F32ToF24(x), C3D_F32ToF24(y), C3D_F32ToF24(z), C3D_F32ToF24(w));
+
+	// Send the attribute
+	GPUCMD_AddIncrementalWrites(GPUREG_FIXEDATTRIB_DATA0, param, 3);
 }
 
-void C3D_ImmSendAttrib(float x, float y, float z, float w)
+// A GPU command carries at most 255 parameters, i.e. 85 packed attributes
+#define C3D_IMM_BURST_ATTRIBS (255/3)
+
+static void C3Di_ImmSendBurst(const float* data, int count)
 {
-	union
-	{
-		u32 packed[3];
-		struct
-		{
-			u8 x[3];
-			u8 y[3];
-			u8 z[3];
-			u8 w[3];
-		};
-	} param;
+	u32 param[C3D_IMM_BURST_ATTRIBS*3];
+	C3D_PackF24x4Array(param, data, count);
 
-	// Convert the values to float24
-	write24(param.x, f32tof24(x));
-	write24(param.y, f32tof24(y));
-	write24(param.z, f32tof24(z));
-	write24(param.w, f32tof24(w));
+	// The fixed attribute data registers latch every third word, so a whole
+	// run of attributes can be streamed through GPUREG_FIXEDATTRIB_DATA0
+	GPUCMD_AddWrites(GPUREG_FIXEDATTRIB_DATA0, param, count*3);
+}
 
-	// Reverse the packed words
-	u32 p = param.packed[0];
-	param.packed[0] = param.packed[2];
-	param.packed[2] = p;
+void C3D_ImmSendAttribs(const float* data, int count)
+{
+	while (count > 0)
+	{
+		int n = count < C3D_IMM_BURST_ATTRIBS ? count : C3D_IMM_BURST_ATTRIBS;
+		C3Di_ImmSendBurst(data, n);
+		data += n*4;
+		count -= n;
+	}
+}
 
-	// Send the attribute
-	GPUCMD_AddIncrementalWrites(GPUREG_FIXEDATTRIB_DATA0, param.packed, 3);
+void C3D_ImmSendVertices(const float* data, int numVerts, int attrsPerVert)
+{
+	if (attrsPerVert <= 0 || attrsPerVert > C3D_IMM_BURST_ATTRIBS)
+		return;
+
+	// Keep whole vertices within each burst
+	int perBurst = C3D_IMM_BURST_ATTRIBS / attrsPerVert;
+	while (numVerts > 0)
+	{
+		int n = numVerts < perBurst ? numVerts : perBurst;
+		C3Di_ImmSendBurst(data, n*attrsPerVert);
+		data += n*attrsPerVert*4;
+		numVerts -= n;
+	}
 }
 
 void C3D_ImmDrawEnd(void)
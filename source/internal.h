@@ -4,7 +4,7 @@
 #include <c3d/proctex.h>
 #include <c3d/light.h>
 #include <c3d/framebuffer.h>
-#include <c3d/texenv.h>
+#include <c3d/texenvmodel.h>
 #include <c3d/fog.h>
 
 #define C3D_UNUSED __attribute__((unused))
@@ -28,6 +28,13 @@ typedef struct
 	GPU_LOGICOP clrLogicOp;
 } C3D_Effect;
 
+// Light LUT last uploaded to a hardware slot: 6 common LUTs, then 8 SP and 8 DA
+typedef struct
+{
+	const C3D_LightLut* lut;
+	u32 generation;
+} C3Di_LightLutSlot;
+
 typedef struct
 {
 	gxCmdQueue_s gxQueue;
@@ -42,15 +49,23 @@ typedef struct
 	C3D_BufInfo bufInfo;
 	C3D_Effect effect;
 	C3D_LightEnv* lightEnv;
+	C3Di_LightLutSlot lightLuts[6+8+8];
+	C3D_LightEnvConf lightEnvHw; // Registers as last sent
+	C3D_LightConf lightHw[8];
+	u16 lightHwValid; // Bits 0-7 for lightHw, bit 8 for lightEnvHw
 
 	u32 texConfig;
 	u32 texShadow;
 	C3D_Tex* tex[3];
 	C3D_TexEnv texEnv[6];
+	C3D_TexEnv texEnvHw[6]; // As last sent, after TexEnv_Optimize
+	u8 texEnvHwValid;
 
 	u32 texEnvBuf, texEnvBufClr;
 	u32 fogClr;
 	C3D_FogLut* fogLut;
+	u32 fogLutHw[128]; // As last uploaded
+	bool fogLutHwValid;
 
 	C3D_ProcTex* procTex;
 	C3D_ProcTexLut* procTexLut[3];
@@ -92,6 +107,14 @@ enum
 	C3DiF_TexEnvAll = 0x3F << 26,
 };
 
+typedef struct
+{
+	u32* start;
+	u32* end;
+	u32 value;
+	u16 control;
+} C3Di_MemFill;
+
 static inline C3D_Context* C3Di_GetContext(void)
 {
 	extern C3D_Context __C3D_Context;
@@ -112,8 +135,14 @@ void C3Di_UpdateContext(void);
 void C3Di_AttrInfoBind(C3D_AttrInfo* info);
 void C3Di_BufInfoBind(C3D_BufInfo* info);
 void C3Di_FrameBufBind(C3D_FrameBuf* fb);
+int C3Di_FrameBufFills(C3D_FrameBuf* fb, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth, C3Di_MemFill* out);
+void C3Di_MemFillSubmit(const C3Di_MemFill* fills, int count);
+void C3Di_FrameBufTransfer(C3D_FrameBuf* fb, gfxScreen_t screen, gfx3dSide_t side, u32 transferFlags);
 void C3Di_TexEnvBind(int id, C3D_TexEnv* env);
+void C3Di_TexEnvUpdate(C3D_Context* ctx);
+void C3Di_FogLutUpdate(C3D_Context* ctx);
 void C3Di_SetTex(int unit, C3D_Tex* tex);
+u32 C3Di_TexInitPlaced(C3D_Tex* tex, void* data, C3D_TexInitParams p);
 void C3Di_EffectBind(C3D_Effect* effect);
 
 void C3Di_LightMtlBlend(C3D_Light* light);
@@ -123,3 +152,6 @@ void C3Di_LoadShaderUniforms(shaderInstance_s* si);
 void C3Di_ClearShaderUniforms(GPU_SHADER_TYPE type);
 
 bool C3Di_SplitFrame(u32** pBuf, u32* pSize);
+u32 C3Di_FrameIndex(void); // Incremented by every C3D_FrameBegin that succeeds
+bool C3Di_FrameMemFill(const C3Di_MemFill* fills, int count);
+void C3Di_RenderQueueWaitDone(void);
@@ -57,7 +57,7 @@ void C3D_LightTwoSideDiffuse(C3D_Light* light, bool enable)
 		light->conf.config |= BIT(1);
 	else
 		light->conf.config &= ~BIT(1);
-	light->flags |= C3DF_Light_Dirty;
+	light->flags |= C3DF_Light_ConfigDirty;
 }
 
 void C3D_LightGeoFactor(C3D_Light* light, int id, bool enable)
@@ -67,7 +67,7 @@ void C3D_LightGeoFactor(C3D_Light* light, int id, bool enable)
 		light->conf.config |= BIT(id);
 	else
 		light->conf.config &= ~BIT(id);
-	light->flags |= C3DF_Light_Dirty;
+	light->flags |= C3DF_Light_ConfigDirty;
 }
 
 void C3D_LightAmbient(C3D_Light* light, float r, float g, float b)
@@ -105,12 +105,16 @@ void C3D_LightSpecular1(C3D_Light* light, float r, float g, float b)
 void C3D_LightPosition(C3D_Light* light, C3D_FVec* pos)
 {
 	// Enable/disable positional light depending on W coordinate
-	light->conf.config &= ~BIT(0);
-	light->conf.config |= (pos->w == 0.0f);
+	u32 config = (light->conf.config &~ BIT(0)) | (pos->w == 0.0f);
+	if (config != light->conf.config)
+	{
+		light->conf.config = config;
+		light->flags |= C3DF_Light_ConfigDirty;
+	}
 	light->conf.position[0] = f32tof16(pos->x);
 	light->conf.position[1] = f32tof16(pos->y);
 	light->conf.position[2] = f32tof16(pos->z);
-	light->flags |= C3DF_Light_Dirty;
+	light->flags |= C3DF_Light_PosDirty;
 }
 
 static void C3Di_EnableCommon(C3D_Light* light, bool enable, u32 bit)
@@ -126,7 +130,7 @@ static void C3Di_EnableCommon(C3D_Light* light, bool enable, u32 bit)
 	else
 		*var &= ~bit;
 
-	env->flags |= C3DF_LightEnv_Dirty;
+	env->flags |= C3DF_LightEnv_ConfigDirty;
 }
 
 void C3D_LightShadowEnable(C3D_Light* light, bool enable)
@@ -152,7 +156,7 @@ void C3D_LightSpotDir(C3D_Light* light, float x, float y, float z)
 	light->conf.spotDir[0] = floattofix2_11(vec.x);
 	light->conf.spotDir[1] = floattofix2_11(vec.y);
 	light->conf.spotDir[2] = floattofix2_11(vec.z);
-	light->flags |= C3DF_Light_Dirty;
+	light->flags |= C3DF_Light_SpotDirty;
 }
 
 void C3D_LightSpotLut(C3D_Light* light, C3D_LightLut* lut)
@@ -178,5 +182,5 @@ void C3D_LightDistAttn(C3D_Light* light, C3D_LightLutDA* lut)
 	light->conf.distAttnBias  = f32tof20(lut->bias);
 	light->conf.distAttnScale = f32tof20(lut->scale);
 	light->lut_DA = &lut->lut;
-	light->flags |= C3DF_Light_Dirty | C3DF_Light_DADirty;
+	light->flags |= C3DF_Light_AttnDirty | C3DF_Light_DADirty;
 }
@@ -15,9 +15,17 @@ static void C3Di_LightEnvMtlBlend(C3D_LightEnv* env)
 	env->conf.ambient = color;
 }
 
-static void C3Di_LightLutUpload(u32 config, C3D_LightLut* lut)
+static void C3Di_LightLutUpload(int slot, u32 config, C3D_LightLut* lut)
 {
 	int i;
+	C3Di_LightLutSlot* s = &C3Di_GetContext()->lightLuts[slot];
+
+	// Skip the upload if the slot already holds this version of the table
+	if (s->lut == lut && s->generation == lut->generation)
+		return;
+	s->lut = lut;
+	s->generation = lut->generation;
+
 	GPUCMD_AddWrite(GPUREG_LIGHTING_LUT_INDEX, config);
 	for (i = 0; i < 256; i += 8)
 		GPUCMD_AddWrites(GPUREG_LIGHTING_LUT_DATA0, &lut->data[i], 8);
@@ -49,6 +57,45 @@ static void C3Di_LightEnvSelectLayer(C3D_LightEnv* env)
 	env->conf.config[0] = (env->conf.config[0] &~ (0xF<<4)) | (GPU_LIGHT_ENV_LAYER_CONFIG(i)<<4);
 }
 
+// Words of C3D_LightConf written for each dirty flag
+static const struct { u16 flag, words; } lightConfGroups[] =
+{
+	{ C3DF_Light_ColorDirty,  0x00F },
+	{ C3DF_Light_PosDirty,    0x030 },
+	{ C3DF_Light_SpotDirty,   0x0C0 },
+	{ C3DF_Light_ConfigDirty, 0x200 },
+	{ C3DF_Light_AttnDirty,   0xC00 },
+};
+
+static void C3Di_LightConfUpload(int id, C3D_Light* light)
+{
+	int i, n;
+	u32 words = 0;
+	for (i = 0; i < 5; i ++)
+		if (light->flags & lightConfGroups[i].flag)
+			words |= lightConfGroups[i].words;
+
+	// Writing the unused word between the spot direction and the config is
+	// cheaper than starting another write
+	if ((words & 0x080) && (words & 0x200))
+		words |= 0x100;
+
+	u32* conf = (u32*)&light->conf;
+	for (i = 0; words; i += n, words >>= n)
+	{
+		for (n = 0; words & BIT(n); n ++);
+		if (n)
+			GPUCMD_AddIncrementalWrites(GPUREG_LIGHT0_SPECULAR0 + id*0x10 + i, &conf[i], n);
+		else
+			n = 1;
+	}
+	light->flags &= ~C3DF_Light_Dirty;
+
+	C3D_Context* ctx = C3Di_GetContext();
+	ctx->lightHw[id] = light->conf;
+	ctx->lightHwValid |= BIT(id);
+}
+
 void C3Di_LightEnvUpdate(C3D_LightEnv* env)
 {
 	int i;
@@ -67,24 +114,39 @@ void C3Di_LightEnvUpdate(C3D_LightEnv* env)
 		}
 		if (conf->numLights > 0) conf->numLights --;
 		env->flags &= ~C3DF_LightEnv_LCDirty;
-		env->flags |= C3DF_LightEnv_Dirty;
+		env->flags |= C3DF_LightEnv_NumDirty | C3DF_LightEnv_PermDirty;
 	}
 
 	if (env->flags & C3DF_LightEnv_MtlDirty)
 	{
 		C3Di_LightEnvMtlBlend(env);
 		env->flags &= ~C3DF_LightEnv_MtlDirty;
-		env->flags |= C3DF_LightEnv_Dirty;
+		env->flags |= C3DF_LightEnv_AmbientDirty;
 	}
 
 	if (env->flags & C3DF_LightEnv_Dirty)
 	{
-		C3Di_LightEnvSelectLayer(env);
-		GPUCMD_AddWrite(GPUREG_LIGHTING_AMBIENT, conf->ambient);
-		GPUCMD_AddIncrementalWrites(GPUREG_LIGHTING_NUM_LIGHTS, (u32*)&conf->numLights, 3);
-		GPUCMD_AddIncrementalWrites(GPUREG_LIGHTING_LUTINPUT_ABS, (u32*)&conf->lutInput, 3);
-		GPUCMD_AddWrite(GPUREG_LIGHTING_LIGHT_PERMUTATION, conf->permutation);
+		u32 flags = env->flags;
+		if (flags & C3DF_LightEnv_AmbientDirty)
+			GPUCMD_AddWrite(GPUREG_LIGHTING_AMBIENT, conf->ambient);
+		if (flags & C3DF_LightEnv_ConfigDirty)
+		{
+			C3Di_LightEnvSelectLayer(env);
+			if (flags & C3DF_LightEnv_NumDirty)
+				GPUCMD_AddIncrementalWrites(GPUREG_LIGHTING_NUM_LIGHTS, (u32*)&conf->numLights, 3);
+			else
+				GPUCMD_AddIncrementalWrites(GPUREG_LIGHTING_CONFIG0, conf->config, 2);
+		} else if (flags & C3DF_LightEnv_NumDirty)
+			GPUCMD_AddWrite(GPUREG_LIGHTING_NUM_LIGHTS, conf->numLights);
+		if (flags & C3DF_LightEnv_InputDirty)
+			GPUCMD_AddIncrementalWrites(GPUREG_LIGHTING_LUTINPUT_ABS, (u32*)&conf->lutInput, 3);
+		if (flags & C3DF_LightEnv_PermDirty)
+			GPUCMD_AddWrite(GPUREG_LIGHTING_LIGHT_PERMUTATION, conf->permutation);
 		env->flags &= ~C3DF_LightEnv_Dirty;
+
+		C3D_Context* ctx = C3Di_GetContext();
+		ctx->lightEnvHw = *conf;
+		ctx->lightHwValid |= BIT(8);
 	}
 
 	if (env->flags & C3DF_LightEnv_LutDirtyAll)
@@ -93,7 +155,7 @@ void C3Di_LightEnvUpdate(C3D_LightEnv* env)
 		{
 			static const u8 lutIds[] = { 0, 1, 3, 4, 5, 6 };
 			if (!(env->flags & C3DF_LightEnv_LutDirty(i))) continue;
-			C3Di_LightLutUpload(GPU_LIGHTLUTIDX(GPU_LUTSELECT_COMMON, (u32)lutIds[i], 0), env->luts[i]);
+			C3Di_LightLutUpload(i, GPU_LIGHTLUTIDX(GPU_LUTSELECT_COMMON, (u32)lutIds[i], 0), env->luts[i]);
 		}
 
 		env->flags &= ~C3DF_LightEnv_LutDirtyAll;
@@ -108,32 +170,28 @@ void C3Di_LightEnvUpdate(C3D_LightEnv* env)
 		{
 			C3Di_LightMtlBlend(light);
 			light->flags &= ~C3DF_Light_MatDirty;
-			light->flags |= C3DF_Light_Dirty;
+			light->flags |= C3DF_Light_ColorDirty;
 		}
 
 		if (light->flags & C3DF_Light_Dirty)
-		{
-			GPUCMD_AddIncrementalWrites(GPUREG_LIGHT0_SPECULAR0 + i*0x10, (u32*)&light->conf, 12);
-			light->flags &= ~C3DF_Light_Dirty;
-		}
+			C3Di_LightConfUpload(i, light);
 
 		if (light->flags & C3DF_Light_SPDirty)
 		{
-			C3Di_LightLutUpload(GPU_LIGHTLUTIDX(GPU_LUTSELECT_SP, i, 0), light->lut_SP);
+			C3Di_LightLutUpload(6+i, GPU_LIGHTLUTIDX(GPU_LUTSELECT_SP, i, 0), light->lut_SP);
 			light->flags &= ~C3DF_Light_SPDirty;
 		}
 
 		if (light->flags & C3DF_Light_DADirty)
 		{
-			C3Di_LightLutUpload(GPU_LIGHTLUTIDX(GPU_LUTSELECT_DA, i, 0), light->lut_DA);
+			C3Di_LightLutUpload(14+i, GPU_LIGHTLUTIDX(GPU_LUTSELECT_DA, i, 0), light->lut_DA);
 			light->flags &= ~C3DF_Light_DADirty;
 		}
 	}
 }
 
-void C3Di_LightEnvDirty(C3D_LightEnv* env)
+static void C3Di_LightEnvLutsDirty(C3D_LightEnv* env)
 {
-	env->flags |= C3DF_LightEnv_Dirty;
 	int i;
 	for (i = 0; i < 6; i ++)
 		if (env->luts[i])
@@ -143,7 +201,6 @@ void C3Di_LightEnvDirty(C3D_LightEnv* env)
 		C3D_Light* light = env->lights[i];
 		if (!light) continue;
 
-		light->flags |= C3DF_Light_Dirty;
 		if (light->lut_SP)
 			light->flags |= C3DF_Light_SPDirty;
 		if (light->lut_DA)
@@ -151,6 +208,64 @@ void C3Di_LightEnvDirty(C3D_LightEnv* env)
 	}
 }
 
+// Marks the register groups that differ from what the previously bound
+// environment left in the GPU
+static void C3Di_LightEnvRegsDirty(C3D_LightEnv* env)
+{
+	int i, j, k;
+	C3D_Context* ctx = C3Di_GetContext();
+	C3D_LightEnvConf* conf = &env->conf;
+	C3D_LightEnvConf* hw = &ctx->lightEnvHw;
+
+	if (!(ctx->lightHwValid & BIT(8)))
+		env->flags |= C3DF_LightEnv_Dirty;
+	else
+	{
+		if (conf->ambient != hw->ambient)
+			env->flags |= C3DF_LightEnv_AmbientDirty;
+		if (conf->numLights != hw->numLights)
+			env->flags |= C3DF_LightEnv_NumDirty;
+		if (memcmp(conf->config, hw->config, sizeof(conf->config)) != 0)
+			env->flags |= C3DF_LightEnv_ConfigDirty;
+		if (memcmp(&conf->lutInput, &hw->lutInput, sizeof(conf->lutInput)) != 0)
+			env->flags |= C3DF_LightEnv_InputDirty;
+		if (conf->permutation != hw->permutation)
+			env->flags |= C3DF_LightEnv_PermDirty;
+	}
+
+	for (i = 0; i < 8; i ++)
+	{
+		C3D_Light* light = env->lights[i];
+		if (!light) continue;
+
+		if (!(ctx->lightHwValid & BIT(i)))
+		{
+			light->flags |= C3DF_Light_Dirty;
+			continue;
+		}
+
+		const u32* cur = (const u32*)&light->conf;
+		const u32* old = (const u32*)&ctx->lightHw[i];
+		for (j = 0; j < 12; j ++)
+		{
+			if (cur[j] == old[j]) continue;
+			for (k = 0; k < 5; k ++)
+				if (lightConfGroups[k].words & BIT(j))
+					light->flags |= lightConfGroups[k].flag;
+		}
+	}
+}
+
+void C3Di_LightEnvDirty(C3D_LightEnv* env)
+{
+	int i;
+	env->flags |= C3DF_LightEnv_Dirty;
+	for (i = 0; i < 8; i ++)
+		if (env->lights[i])
+			env->lights[i]->flags |= C3DF_Light_Dirty;
+	C3Di_LightEnvLutsDirty(env);
+}
+
 void C3D_LightEnvInit(C3D_LightEnv* env)
 {
 	memset(env, 0, sizeof(*env));
@@ -174,6 +289,14 @@ void C3D_LightEnvBind(C3D_LightEnv* env)
 
 	ctx->flags |= C3DiF_LightEnv;
 	ctx->lightEnv = env;
+
+	// The previous environment may have replaced any of our registers and
+	// LUTs, resident ones are filtered out by C3Di_LightLutUpload
+	if (env)
+	{
+		C3Di_LightEnvRegsDirty(env);
+		C3Di_LightEnvLutsDirty(env);
+	}
 }
 
 void C3D_LightEnvMaterial(C3D_LightEnv* env, const C3D_Material* mtl)
@@ -222,7 +345,7 @@ void C3D_LightEnvLut(C3D_LightEnv* env, GPU_LIGHTLUTID lutId, GPU_LIGHTLUTINPUT
 	if (negative)
 		env->conf.lutInput.abs |= absbit;
 
-	env->flags |= C3DF_LightEnv_Dirty;
+	env->flags |= C3DF_LightEnv_ConfigDirty | C3DF_LightEnv_InputDirty;
 	if (input == GPU_LUTINPUT_CP)
 		env->flags |= C3DF_LightEnv_IsCP(lutId);
 	else
@@ -233,21 +356,21 @@ void C3D_LightEnvFresnel(C3D_LightEnv* env, GPU_FRESNELSEL selector)
 {
 	env->conf.config[0] &= ~(3<<2);
 	env->conf.config[0] |= (selector&3)<<2;
-	env->flags |= C3DF_LightEnv_Dirty;
+	env->flags |= C3DF_LightEnv_ConfigDirty;
 }
 
 void C3D_LightEnvBumpMode(C3D_LightEnv* env, GPU_BUMPMODE mode)
 {
 	env->conf.config[0] &= ~(3<<28);
 	env->conf.config[0] |= (mode&3)<<28;
-	env->flags |= C3DF_LightEnv_Dirty;
+	env->flags |= C3DF_LightEnv_ConfigDirty;
 }
 
 void C3D_LightEnvBumpSel(C3D_LightEnv* env, int texUnit)
 {
 	env->conf.config[0] &= ~(3<<22);
 	env->conf.config[0] |= (texUnit&3)<<22;
-	env->flags |= C3DF_LightEnv_Dirty;
+	env->flags |= C3DF_LightEnv_ConfigDirty;
 }
 
 void C3D_LightEnvShadowMode(C3D_LightEnv* env, u32 mode)
@@ -257,14 +380,14 @@ void C3D_LightEnvShadowMode(C3D_LightEnv* env, u32 mode)
 		mode |= BIT(0);
 	env->conf.config[0] &= ~((0xF<<16) | BIT(0));
 	env->conf.config[0] |= mode;
-	env->flags |= C3DF_LightEnv_Dirty;
+	env->flags |= C3DF_LightEnv_ConfigDirty;
 }
 
 void C3D_LightEnvShadowSel(C3D_LightEnv* env, int texUnit)
 {
 	env->conf.config[0] &= ~(3<<24);
 	env->conf.config[0] |= (texUnit&3)<<24;
-	env->flags |= C3DF_LightEnv_Dirty;
+	env->flags |= C3DF_LightEnv_ConfigDirty;
 }
 
 void C3D_LightEnvClampHighlights(C3D_LightEnv* env, bool clamp)
@@ -273,5 +396,79 @@ void C3D_LightEnvClampHighlights(C3D_LightEnv* env, bool clamp)
 		env->conf.config[0] |= BIT(27);
 	else
 		env->conf.config[0] &= ~BIT(27);
-	env->flags |= C3DF_LightEnv_Dirty;
+	env->flags |= C3DF_LightEnv_ConfigDirty;
+}
+
+void C3D_LightEnvBRDFInit(C3D_LightEnvBRDF* brdf, C3D_BRDFDistribution dist, float roughness, const float f0[3])
+{
+	float alpha = roughness*roughness;
+	C3D_LightLutDesc fresnel[3] =
+	{
+		{ C3D_LIGHTLUT_FRESNEL, f0[0], false },
+		{ C3D_LIGHTLUT_FRESNEL, f0[1], false },
+		{ C3D_LIGHTLUT_FRESNEL, f0[2], false },
+	};
+
+	brdf->peak = 1.0f / (M_PI*alpha*alpha);
+	if (dist == C3D_BRDF_BECKMANN)
+		brdf->peak *= beckmann_max(alpha);
+	brdf->colored = f0[0] != f0[1] || f0[0] != f0[2];
+	LightLut_FromShape(&brdf->dist, dist == C3D_BRDF_BECKMANN ? C3D_LIGHTLUT_BECKMANN : C3D_LIGHTLUT_GGX, alpha, false);
+	LightLut_FromShapes(brdf->fresnel, fresnel, brdf->colored ? 3 : 1);
+}
+
+void C3D_LightEnvCookTorrance(C3D_LightEnv* env, C3D_LightEnvBRDF* brdf)
+{
+	// RG and RB follow RR while disabled
+	C3D_LightEnvLut(env, GPU_LUT_D0, GPU_LUTINPUT_NH, false, NULL);
+	C3D_LightEnvLut(env, GPU_LUT_D1, GPU_LUTINPUT_NH, false, &brdf->dist);
+	C3D_LightEnvLut(env, GPU_LUT_RR, GPU_LUTINPUT_VH, false, &brdf->fresnel[0]);
+	C3D_LightEnvLut(env, GPU_LUT_RG, GPU_LUTINPUT_VH, false, brdf->colored ? &brdf->fresnel[1] : NULL);
+	C3D_LightEnvLut(env, GPU_LUT_RB, GPU_LUTINPUT_VH, false, brdf->colored ? &brdf->fresnel[2] : NULL);
+}
+
+void C3D_LightEnvGetModel(C3D_LightEnv* env, C3D_LightModel* model)
+{
+	int i;
+	static const s8 ids[] = { 0, 1, -1, 2, 3, 4, 5, -1 };
+	C3D_LightEnvConf* conf = &env->conf;
+
+	// Derived register values, as C3Di_LightEnvUpdate computes them
+	C3Di_LightEnvMtlBlend(env);
+	C3Di_LightEnvSelectLayer(env);
+
+	memset(model, 0, sizeof(*model));
+	model->ambient   = conf->ambient;
+	model->config[0] = conf->config[0];
+	model->config[1] = conf->config[1];
+	model->lutAbs    = conf->lutInput.abs;
+	model->lutSelect = conf->lutInput.select;
+	model->lutScale  = conf->lutInput.scale;
+	for (i = 0; i < 8; i ++)
+		if (ids[i] >= 0)
+			model->luts[i] = env->luts[ids[i]];
+
+	for (i = 0; i < 8; i ++)
+	{
+		C3D_Light* light = env->lights[i];
+		if (!light) continue;
+
+		C3Di_LightMtlBlend(light);
+		C3D_LightModelLight* ml = &model->lights[i];
+		ml->specular0 = light->conf.material.specular0;
+		ml->specular1 = light->conf.material.specular1;
+		ml->diffuse   = light->conf.material.diffuse;
+		ml->ambient   = light->conf.material.ambient;
+		memcpy(ml->position, light->conf.position, sizeof(ml->position));
+		memcpy(ml->spotDir, light->conf.spotDir, sizeof(ml->spotDir));
+		ml->config        = light->conf.config;
+		ml->distAttnBias  = light->conf.distAttnBias;
+		ml->distAttnScale = light->conf.distAttnScale;
+		ml->lutSP = light->lut_SP;
+		ml->lutDA = light->lut_DA;
+
+		if (light->flags & C3DF_Light_Enabled)
+			model->permutation |= GPU_LIGHTPERM(model->numLights++, i);
+	}
+	if (model->numLights > 0) model->numLights --;
 }
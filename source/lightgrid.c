@@ -0,0 +1,304 @@
+#include <c3d/lightgrid.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline int cellCoord(float v, float cellSize)
+{
+	return (int)floorf(v / cellSize);
+}
+
+static inline u32 cellHash(int x, int y, int z)
+{
+	return ((u32)x*73856093U ^ (u32)y*19349663U ^ (u32)z*83492791U) & (C3D_LIGHTGRID_BUCKETS-1);
+}
+
+// Cell range overlapped by a box, returns false if it covers too many cells
+static bool cellRange(const C3D_LightGrid* grid, const float* min, const float* max, int* lo, int* hi)
+{
+	int i, count = 1;
+	for (i = 0; i < 3; i ++)
+	{
+		lo[i] = cellCoord(min[i], grid->cellSize);
+		hi[i] = cellCoord(max[i], grid->cellSize);
+		count *= hi[i]-lo[i]+1;
+		if (count > C3D_LIGHTGRID_MAX_CELLS || count <= 0)
+			return false;
+	}
+	return true;
+}
+
+static bool lightRange(const C3D_LightGrid* grid, const C3D_PointLight* l, int* lo, int* hi)
+{
+	float min[3] = { l->pos.x-l->radius, l->pos.y-l->radius, l->pos.z-l->radius };
+	float max[3] = { l->pos.x+l->radius, l->pos.y+l->radius, l->pos.z+l->radius };
+	return cellRange(grid, min, max, lo, hi);
+}
+
+bool LightGrid_Init(C3D_LightGrid* grid, float cellSize)
+{
+	memset(grid, 0, sizeof(*grid));
+	if (cellSize <= 0.0f)
+		return false;
+
+	grid->bucketStart = (u32*)calloc(C3D_LIGHTGRID_BUCKETS+1, sizeof(u32));
+	if (!grid->bucketStart)
+		return false;
+
+	grid->cellSize = cellSize;
+	return true;
+}
+
+void LightGrid_Free(C3D_LightGrid* grid)
+{
+	free(grid->lights);
+	free(grid->stamp);
+	free(grid->bucketStart);
+	free(grid->cellLights);
+	free(grid->bigLights);
+	memset(grid, 0, sizeof(*grid));
+}
+
+int LightGrid_Add(C3D_LightGrid* grid, const C3D_PointLight* light)
+{
+	if (grid->numLights == grid->maxLights)
+	{
+		int max = grid->maxLights ? 2*grid->maxLights : 64;
+		C3D_PointLight* lights = (C3D_PointLight*)realloc(grid->lights, max*sizeof(C3D_PointLight));
+		if (!lights)
+			return -1;
+		grid->lights = lights;
+
+		u32* stamp = (u32*)realloc(grid->stamp, max*sizeof(u32));
+		if (!stamp)
+			return -1;
+		memset(stamp + grid->maxLights, 0, (max-grid->maxLights)*sizeof(u32));
+		grid->stamp = stamp;
+		grid->maxLights = max;
+	}
+
+	grid->lights[grid->numLights] = *light;
+	return grid->numLights++;
+}
+
+void LightGrid_Clear(C3D_LightGrid* grid)
+{
+	grid->numLights = 0;
+	grid->numCellLights = 0;
+	grid->numBigLights = 0;
+	memset(grid->bucketStart, 0, (C3D_LIGHTGRID_BUCKETS+1)*sizeof(u32));
+}
+
+void LightGrid_Build(C3D_LightGrid* grid)
+{
+	int i, x, y, z;
+	int lo[3], hi[3];
+	u32* start = grid->bucketStart;
+
+	// Count the grid entries per bucket, then fill them in
+	memset(start, 0, (C3D_LIGHTGRID_BUCKETS+1)*sizeof(u32));
+	int numBig = 0;
+	for (i = 0; i < grid->numLights; i ++)
+	{
+		const C3D_PointLight* l = &grid->lights[i];
+		if (l->radius <= 0.0f) continue;
+		if (!lightRange(grid, l, lo, hi))
+		{
+			numBig ++;
+			continue;
+		}
+		for (z = lo[2]; z <= hi[2]; z ++)
+			for (y = lo[1]; y <= hi[1]; y ++)
+				for (x = lo[0]; x <= hi[0]; x ++)
+					start[cellHash(x, y, z)+1] ++;
+	}
+	for (i = 0; i < C3D_LIGHTGRID_BUCKETS; i ++)
+		start[i+1] += start[i];
+
+	int total = start[C3D_LIGHTGRID_BUCKETS];
+	if (total > grid->maxCellLights)
+	{
+		free(grid->cellLights);
+		grid->cellLights = (u32*)malloc(total*sizeof(u32));
+		grid->maxCellLights = grid->cellLights ? total : 0;
+	}
+	free(grid->bigLights);
+	grid->bigLights = numBig ? (u32*)malloc(numBig*sizeof(u32)) : NULL;
+
+	// Allocation failures leave those lights out rather than failing the frame
+	grid->numCellLights = grid->cellLights ? total : 0;
+	grid->numBigLights = 0;
+	if (!grid->cellLights)
+		memset(start, 0, (C3D_LIGHTGRID_BUCKETS+1)*sizeof(u32));
+
+	for (i = 0; i < grid->numLights; i ++)
+	{
+		const C3D_PointLight* l = &grid->lights[i];
+		if (l->radius <= 0.0f) continue;
+		if (!lightRange(grid, l, lo, hi))
+		{
+			if (grid->bigLights)
+				grid->bigLights[grid->numBigLights++] = i;
+			continue;
+		}
+		if (!grid->cellLights) continue;
+		for (z = lo[2]; z <= hi[2]; z ++)
+			for (y = lo[1]; y <= hi[1]; y ++)
+				for (x = lo[0]; x <= hi[0]; x ++)
+					grid->cellLights[start[cellHash(x, y, z)]++] = i;
+	}
+
+	// Filling advanced each bucket start to the next one, shift them back
+	if (grid->cellLights)
+	{
+		for (i = C3D_LIGHTGRID_BUCKETS; i > 0; i --)
+			start[i] = start[i-1];
+		start[0] = 0;
+	}
+}
+
+float LightGrid_Score(const C3D_PointLight* l, const C3D_AABB* bounds)
+{
+	int i;
+	float p[3] = { l->pos.x, l->pos.y, l->pos.z };
+	float min[3] = { bounds->min.x, bounds->min.y, bounds->min.z };
+	float max[3] = { bounds->max.x, bounds->max.y, bounds->max.z };
+	float d2 = 0.0f;
+	for (i = 0; i < 3; i ++)
+	{
+		float d = 0.0f;
+		if (p[i] < min[i]) d = min[i]-p[i];
+		else if (p[i] > max[i]) d = p[i]-max[i];
+		d2 += d*d;
+	}
+
+	float r2 = l->radius*l->radius;
+	if (d2 >= r2) return 0.0f;
+
+	float w = 1.0f - d2/r2;
+	return (0.2126f*l->color[0] + 0.7152f*l->color[1] + 0.0722f*l->color[2])*w*w;
+}
+
+typedef struct
+{
+	int* id;
+	float score[8];
+	int count, max;
+} Selection;
+
+static void considerLight(C3D_LightGrid* grid, Selection* sel, u32 id, const C3D_AABB* bounds)
+{
+	int i;
+	if (grid->stamp[id] == grid->curStamp) return;
+	grid->stamp[id] = grid->curStamp;
+
+	float score = LightGrid_Score(&grid->lights[id], bounds);
+	if (score <= 0.0f) return;
+
+	// Insertion into the short list of best lights, kept sorted
+	if (sel->count == sel->max && score <= sel->score[sel->count-1])
+		return;
+	i = sel->count < sel->max ? sel->count++ : sel->count-1;
+	for (; i > 0 && sel->score[i-1] < score; i --)
+	{
+		sel->score[i] = sel->score[i-1];
+		sel->id[i] = sel->id[i-1];
+	}
+	sel->score[i] = score;
+	sel->id[i] = id;
+}
+
+int LightGrid_Query(C3D_LightGrid* grid, const C3D_AABB* bounds, int* ids, int maxIds)
+{
+	int i, j, x, y, z;
+	int lo[3], hi[3];
+	float min[3] = { bounds->min.x, bounds->min.y, bounds->min.z };
+	float max[3] = { bounds->max.x, bounds->max.y, bounds->max.z };
+
+	Selection sel;
+	sel.id = ids;
+	sel.count = 0;
+	sel.max = maxIds < 8 ? maxIds : 8;
+	if (sel.max <= 0)
+		return 0;
+
+	if (!++grid->curStamp)
+	{
+		// Stamp wrapped around, forget all previous queries
+		memset(grid->stamp, 0, grid->maxLights*sizeof(u32));
+		grid->curStamp = 1;
+	}
+
+	for (i = 0; i < grid->numBigLights; i ++)
+		considerLight(grid, &sel, grid->bigLights[i], bounds);
+
+	if (cellRange(grid, min, max, lo, hi))
+	{
+		for (z = lo[2]; z <= hi[2]; z ++)
+			for (y = lo[1]; y <= hi[1]; y ++)
+				for (x = lo[0]; x <= hi[0]; x ++)
+				{
+					u32 b = cellHash(x, y, z);
+					for (j = grid->bucketStart[b]; j < (int)grid->bucketStart[b+1]; j ++)
+						considerLight(grid, &sel, grid->cellLights[j], bounds);
+				}
+	} else
+	{
+		for (i = 0; i < grid->numCellLights; i ++)
+			considerLight(grid, &sel, grid->cellLights[i], bounds);
+	}
+
+	return sel.count;
+}
+
+u8 LightGrid_AssignSlots(int* slotLight, u8 slotValid, int numSlots, const int* ids, int count, u8* load)
+{
+	int i, j;
+
+	// Picked lights that are still loaded keep their slot
+	u8 used = 0, placed = 0;
+	for (i = 0; i < count; i ++)
+		for (j = 0; j < numSlots; j ++)
+			if (slotLight[j] == ids[i] && (slotValid & BIT(j)))
+			{
+				used |= BIT(j);
+				placed |= BIT(i);
+				break;
+			}
+
+	// The rest go to slots holding lights that weren't picked, preferring empty ones
+	*load = 0;
+	for (i = 0; i < count; i ++)
+	{
+		if (placed & BIT(i)) continue;
+		int slot = -1;
+		for (j = 0; j < numSlots; j ++)
+		{
+			if (used & BIT(j)) continue;
+			if (slot < 0 || slotLight[j] < 0)
+				slot = j;
+			if (slotLight[j] < 0)
+				break;
+		}
+		slotLight[slot] = ids[i];
+		used |= BIT(slot);
+		*load |= BIT(slot);
+	}
+	return used;
+}
+
+// A write takes a header word on top of its values and is padded to an even length
+static inline u32 cmdWords(u32 values)
+{
+	return (values + 2) &~ 1;
+}
+
+u32 LightGrid_LoadWords(const C3D_LightLut* slotDA, const C3D_PointLight* light)
+{
+	u32 words = cmdWords(6); // Colors and position
+	if (light->distAttn)
+		words += cmdWords(2); // Attenuation bias and scale
+	if (LightGrid_NeedsDATable(slotDA, light))
+		words += cmdWords(1) + 32*cmdWords(8); // Table index, then 8 entries per write
+	return words;
+}
@@ -1,9 +1,55 @@
-#include "internal.h"
+#include <c3d/lightlut.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+typedef struct
+{
+	C3D_LightLut* lut;
+	u32 param; // Raw bits, so that -0.0f and NaNs have a well defined key
+	u8 shape;
+	bool negative;
+} C3Di_LightLutCacheEntry;
+
+static C3Di_LightLutCacheEntry lutCache[C3D_LIGHTLUT_CACHE_SIZE];
+static int lutCacheCount;
+static u32 lutGeneration;
+
+void LightLut_Changed(C3D_LightLut* lut)
+{
+	// Unique across tables, so a table rebuilt in memory that held another one
+	// never matches what the GPU was last given
+	lut->generation = ++lutGeneration;
+}
 
 void LightLut_FromArray(C3D_LightLut* lut, float* data)
 {
-	int i;
-	for (i = 0; i < 256; i ++)
+	int i = 0;
+#if defined(__SSE2__)
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	for (; i < 256; i += 4)
+	{
+		__m128 in = _mm_loadu_ps(&data[i]), diff = _mm_loadu_ps(&data[i+256]);
+
+		// Same comparisons as the scalar path below, NaNs included
+		__m128 t = _mm_mul_ps(in, _mm_set1_ps(0x1000));
+		__m128i sat = _mm_castps_si128(_mm_cmpnlt_ps(t, _mm_set1_ps(0x1000)));
+		__m128i val = _mm_or_si128(_mm_andnot_si128(sat, _mm_cvttps_epi32(t)), _mm_and_si128(sat, _mm_set1_epi32(0xFFF)));
+		val = _mm_and_si128(val, _mm_castps_si128(_mm_cmpgt_ps(in, zero)));
+
+		__m128 d = _mm_mul_ps(_mm_and_ps(diff, absMask), _mm_set1_ps(0x800));
+		sat = _mm_castps_si128(_mm_cmpnlt_ps(d, _mm_set1_ps(0x800)));
+		__m128i val2 = _mm_or_si128(_mm_andnot_si128(sat, _mm_cvttps_epi32(d)), _mm_and_si128(sat, _mm_set1_epi32(0x7FF)));
+		val2 = _mm_or_si128(val2, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(diff, zero)), _mm_set1_epi32(0x800)));
+		val2 = _mm_and_si128(val2, _mm_castps_si128(_mm_cmpneq_ps(diff, zero)));
+
+		_mm_storeu_si128((__m128i*)&lut->data[i], _mm_or_si128(val, _mm_slli_epi32(val2, 12)));
+	}
+#endif
+	for (; i < 256; i ++)
 	{
 		float in = data[i], diff = data[i+256];
 
@@ -28,46 +74,170 @@ void LightLut_FromArray(C3D_LightLut* lut, float* data)
 
 		lut->data[i] = val | (val2 << 12);
 	}
+	LightLut_Changed(lut);
 }
 
-void LightLut_FromFunc(C3D_LightLut* lut, C3D_LightLutFunc func, float param, bool negative)
+// Packs the 257 samples taken at x = i/max, i = min..max. Negative tables store
+// x >= 0 in entries 0..127 and x < 0 in entries 128..255, so the last entry
+// (x = -1/128) steps to x = 0.
+static void C3Di_LightLutFromSamples(C3D_LightLut* lut, const float* y, bool negative)
 {
 	int i;
 	float data[512];
-	memset(data, 0, sizeof(data));
+	if (negative)
+	{
+		for (i = 0; i < 128; i ++)
+		{
+			data[i]     = y[i+128];
+			data[i+128] = y[i];
+			data[i+256] = y[i+129]-y[i+128];
+			data[i+384] = y[i+1]-y[i];
+		}
+	} else
+	{
+		for (i = 0; i < 256; i ++)
+		{
+			data[i]     = y[i];
+			data[i+256] = y[i+1]-y[i];
+		}
+	}
+	LightLut_FromArray(lut, data);
+}
+
+void LightLut_FromFunc(C3D_LightLut* lut, C3D_LightLutFunc func, float param, bool negative)
+{
+	int i;
+	float y[257];
 	int min = negative ? (-128) : 0;
 	int max = negative ?   128  : 256;
 	for (i = min; i <= max; i ++)
+		y[i-min] = func((float)i/max, param);
+	C3Di_LightLutFromSamples(lut, y, negative);
+}
+
+void LightLut_FromShape(C3D_LightLut* lut, C3D_LightLutShape shape, float param, bool negative)
+{
+	int i;
+	float x[257], y[257];
+	int min = negative ? (-128) : 0;
+	int max = negative ?   128  : 256;
+	for (i = 0; i < 257; i ++)
+		x[i] = (float)(i+min)/max;
+
+	// One tight loop per shape instead of a callback per entry
+	switch (shape)
 	{
-		float x   = (float)i/max;
-		float val = func(x, param);
-		int   idx = negative ? (i & 0xFF) : i;
-		if (i < max)
-			data[idx] = val;
-		if (i > min)
-			data[idx+255] = val-data[idx-1];
+		case C3D_LIGHTLUT_PHONG:
+			for (i = 0; i < 257; i ++)
+				y[i] = powf(x[i], param);
+			break;
+		case C3D_LIGHTLUT_SPOT_STEP:
+			for (i = 0; i < 257; i ++)
+				y[i] = spot_step(x[i], param);
+			break;
+		case C3D_LIGHTLUT_SPOT_SMOOTH:
+			for (i = 0; i < 257; i ++)
+				y[i] = spot_smoothstep(x[i], param);
+			break;
+		case C3D_LIGHTLUT_FRESNEL:
+			for (i = 0; i < 257; i ++)
+				y[i] = fresnel_schlick(x[i], param);
+			break;
+		case C3D_LIGHTLUT_GGX:
+			for (i = 0; i < 257; i ++)
+				y[i] = ggx_distribution(x[i], param);
+			break;
+		case C3D_LIGHTLUT_BECKMANN:
+			for (i = 0; i < 257; i ++)
+				y[i] = beckmann_distribution(x[i], param);
+			break;
+		case C3D_LIGHTLUT_SMITH:
+			for (i = 0; i < 257; i ++)
+				y[i] = smith_ggx(x[i], param);
+			break;
+		default:
+			memset(y, 0, sizeof(y));
+			break;
 	}
-	LightLut_FromArray(lut, data);
+	C3Di_LightLutFromSamples(lut, y, negative);
 }
 
-void LightLutDA_Create(C3D_LightLutDA* lut, C3D_LightLutFuncDA func, float from, float to, float arg0, float arg1)
+void LightLut_FromShapes(C3D_LightLut* luts, const C3D_LightLutDesc* descs, int count)
+{
+	int i;
+	for (i = 0; i < count; i ++)
+		LightLut_FromShape(&luts[i], descs[i].shape, descs[i].param, descs[i].negative);
+}
+
+static void C3Di_LightLutDAFromSamples(C3D_LightLutDA* lut, const float* y, float from, float range)
 {
 	int i;
 	float data[512];
 
-	float range = to-from;
 	lut->scale = 1.0f / range;
 	lut->bias = -from*lut->scale;
 
+	for (i = 0; i < 256; i ++)
+	{
+		data[i]     = y[i];
+		data[i+256] = y[i+1]-y[i];
+	}
+	LightLut_FromArray(&lut->lut, data);
+}
+
+void LightLutDA_Create(C3D_LightLutDA* lut, C3D_LightLutFuncDA func, float from, float to, float arg0, float arg1)
+{
+	int i;
+	float y[257];
+	float range = to-from;
+	for (i = 0; i <= 256; i ++)
+		y[i] = func(from + range*i/256.0f, arg0, arg1);
+	C3Di_LightLutDAFromSamples(lut, y, from, range);
+}
+
+void LightLutDA_Quadratic(C3D_LightLutDA* lut, float from, float to, float linear, float quad)
+{
+	int i;
+	float y[257];
+	float range = to-from;
 	for (i = 0; i <= 256; i ++)
+		y[i] = quadratic_dist_attn(from + range*i/256.0f, linear, quad);
+	C3Di_LightLutDAFromSamples(lut, y, from, range);
+}
+
+C3D_LightLut* LightLut_Cached(C3D_LightLutShape shape, float param, bool negative)
+{
+	int i;
+	u32 bits;
+	memcpy(&bits, &param, sizeof(bits));
+
+	for (i = 0; i < lutCacheCount; i ++)
 	{
-		float x   = from + range*i/256.0f;
-		float val = func(x, arg0, arg1);
-		if (i < 256)
-			data[i] = val;
-		if (i > 0)
-			data[i+255] = val-data[i-1];
+		C3Di_LightLutCacheEntry* e = &lutCache[i];
+		if (e->param == bits && e->shape == shape && e->negative == negative)
+			return e->lut;
 	}
 
-	LightLut_FromArray(&lut->lut, data);
+	if (lutCacheCount == C3D_LIGHTLUT_CACHE_SIZE)
+		return NULL;
+
+	C3D_LightLut* lut = (C3D_LightLut*)malloc(sizeof(C3D_LightLut));
+	if (!lut)
+		return NULL;
+	LightLut_FromShape(lut, shape, param, negative);
+
+	C3Di_LightLutCacheEntry* e = &lutCache[lutCacheCount++];
+	e->lut = lut;
+	e->param = bits;
+	e->shape = shape;
+	e->negative = negative;
+	return lut;
+}
+
+void LightLut_CacheClear(void)
+{
+	int i;
+	for (i = 0; i < lutCacheCount; i ++)
+		free(lutCache[i].lut);
+	lutCacheCount = 0;
 }
@@ -0,0 +1,103 @@
+#include "internal.h"
+#include <c3d/lightmgr.h>
+
+bool LightMgr_Init(C3D_LightMgr* mgr, C3D_LightEnv* env, int perObject, float cellSize)
+{
+	int i;
+	memset(mgr, 0, sizeof(*mgr));
+	if (perObject < 1 || perObject > 8)
+		return false;
+	if (!LightGrid_Init(&mgr->grid, cellSize))
+		return false;
+
+	mgr->env = env;
+	for (i = 0; i < perObject; i ++)
+	{
+		if (C3D_LightInit(&mgr->hw[i], env) < 0)
+		{
+			LightMgr_Free(mgr);
+			return false;
+		}
+		C3D_LightEnable(&mgr->hw[i], false);
+		mgr->slotLight[i] = -1;
+		mgr->numHw ++;
+	}
+
+	Mtx_Identity(&mgr->view);
+	return true;
+}
+
+void LightMgr_Free(C3D_LightMgr* mgr)
+{
+	int i;
+	for (i = 0; i < mgr->numHw; i ++)
+	{
+		C3D_Light* light = &mgr->hw[i];
+		C3D_LightEnable(light, false);
+		mgr->env->lights[light->id] = NULL;
+	}
+	LightGrid_Free(&mgr->grid);
+	memset(mgr, 0, sizeof(*mgr));
+}
+
+int LightMgr_Add(C3D_LightMgr* mgr, const C3D_PointLight* light)
+{
+	return LightGrid_Add(&mgr->grid, light);
+}
+
+void LightMgr_Clear(C3D_LightMgr* mgr)
+{
+	LightGrid_Clear(&mgr->grid);
+	mgr->slotValid = 0;
+}
+
+void LightMgr_Build(C3D_LightMgr* mgr, const C3D_Mtx* view)
+{
+	Mtx_Copy(&mgr->view, view);
+	mgr->slotValid = 0;
+	LightGrid_Build(&mgr->grid);
+}
+
+static void loadLight(C3D_LightMgr* mgr, int slot)
+{
+	C3D_Light* hw = &mgr->hw[slot];
+	const C3D_PointLight* l = LightGrid_Get(&mgr->grid, mgr->slotLight[slot]);
+
+	C3D_FVec pos = Mtx_MultiplyFVecH(&mgr->view, l->pos);
+	pos.w = 1.0f;
+	C3D_LightPosition(hw, &pos);
+	C3D_LightColor(hw, l->color[0], l->color[1], l->color[2]);
+	if (!l->distAttn)
+		C3D_LightDistAttnEnable(hw, false);
+	else if (LightGrid_NeedsDATable(hw->lut_DA, l))
+		C3D_LightDistAttn(hw, l->distAttn);
+	else
+	{
+		// The slot holds the table already, only its range is reloaded. The
+		// table is only sent again if it was rebuilt since its upload.
+		C3D_LightDistAttnEnable(hw, true);
+		hw->conf.distAttnBias  = f32tof20(l->distAttn->bias);
+		hw->conf.distAttnScale = f32tof20(l->distAttn->scale);
+		hw->flags |= C3DF_Light_AttnDirty | C3DF_Light_DADirty;
+	}
+
+	mgr->slotValid |= BIT(slot);
+}
+
+int LightMgr_Select(C3D_LightMgr* mgr, const C3D_AABB* bounds)
+{
+	int i, ids[8];
+	u8 load;
+	int count = LightGrid_Query(&mgr->grid, bounds, ids, mgr->numHw);
+	u8 used = LightGrid_AssignSlots(mgr->slotLight, mgr->slotValid, mgr->numHw, ids, count, &load);
+
+	for (i = 0; i < mgr->numHw; i ++)
+		if (load & BIT(i))
+			loadLight(mgr, i);
+
+	// Only changes in which slots are enabled touch the light permutation
+	for (i = 0; i < mgr->numHw; i ++)
+		C3D_LightEnable(&mgr->hw[i], (used & BIT(i)) != 0);
+
+	return count;
+}
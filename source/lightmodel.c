@@ -0,0 +1,238 @@
+#include <c3d/lightmodel.h>
+#include <c3d/floatpack.h>
+#include <stddef.h>
+
+// GPU_LIGHTLUTID values
+enum { LUT_D0, LUT_D1, LUT_SP, LUT_FR, LUT_RB, LUT_RG, LUT_RR, LUT_DA };
+
+// LUTs available in each layer configuration, see C3Di_LightEnvSelectLayer
+static const u8 layerLuts[8] =
+{
+	BIT(LUT_D0) | BIT(LUT_RR) | BIT(LUT_SP) | BIT(LUT_DA),
+	BIT(LUT_FR) | BIT(LUT_RR) | BIT(LUT_SP) | BIT(LUT_DA),
+	BIT(LUT_D0) | BIT(LUT_D1) | BIT(LUT_RR) | BIT(LUT_DA),
+	BIT(LUT_D0) | BIT(LUT_D1) | BIT(LUT_FR) | BIT(LUT_DA),
+	0xFF &~ BIT(LUT_FR),
+	0xFF &~ BIT(LUT_D1),
+	0xFF &~ (BIT(LUT_RB) | BIT(LUT_RG)),
+	0xFF,
+};
+
+typedef struct
+{
+	float diffuse[3], ambient[3], specular0[3], specular1[3]; // r, g, b
+	float pos[3], spotDir[3];
+	float distBias, distScale;
+	const C3D_LightLut* lutSP;
+	const C3D_LightLut* lutDA;
+	bool directional, twoSided, geo0, geo1;
+} Light;
+
+typedef struct
+{
+	float x, y, z;
+} Vec;
+
+static inline float dot(Vec a, Vec b)
+{
+	return a.x*b.x + a.y*b.y + a.z*b.z;
+}
+
+static inline Vec normalize(Vec v)
+{
+	float len2 = dot(v, v);
+	if (len2 > 0.0f)
+	{
+		float inv = 1.0f / sqrtf(len2);
+		v.x *= inv; v.y *= inv; v.z *= inv;
+	}
+	return v;
+}
+
+static inline u8 toByte(float c)
+{
+	if (!(c > 0.0f)) return 0;
+	if (c >= 1.0f) return 255;
+	return (u8)(c*255.0f);
+}
+
+static void unpackColor(float* out, u32 packed)
+{
+	int i;
+	for (i = 0; i < 3; i ++)
+		out[2-i] = (float)((packed >> (i*10)) & 0x3FF) / 255.0f;
+}
+
+// Entries hold a 0.12 value and a sign-magnitude 0.11 difference to the next one
+static inline float lutSample(const C3D_LightLut* lut, int index, float delta)
+{
+	u32 e = lut->data[index];
+	float diff = (float)((e >> 12) & 0x7FF) / 0x800;
+	if (e & BIT(23)) diff = -diff;
+	return (float)(e & 0xFFF) / 0x1000 + diff*delta;
+}
+
+static float lutLookup(const C3D_LightLut* lut, float x, bool abs, bool twoSided)
+{
+	int index;
+	float delta;
+	if (abs)
+	{
+		x = twoSided ? fabsf(x) : fmaxf(x, 0.0f);
+		float f = floorf(x*256.0f);
+		index = f < 0.0f ? 0 : f > 255.0f ? 255 : (int)f;
+		delta = x*256.0f - index;
+	} else
+	{
+		float f = floorf(x*128.0f);
+		int s = f < -128.0f ? -128 : f > 127.0f ? 127 : (int)f;
+		delta = x*128.0f - s;
+		index = s & 0xFF;
+	}
+	return lutSample(lut, index, delta);
+}
+
+// Looks up a LUT with the input, abs mode and scale the environment selected for it
+static float lutTerm(const C3D_LightModel* m, const C3D_LightLut* lut, int id, const float* inputs, bool twoSided)
+{
+	static const float scales[8] = { 1.0f, 2.0f, 4.0f, 8.0f, 1.0f, 1.0f, 0.25f, 0.5f };
+	float x = inputs[(m->lutSelect >> (id*4)) & 7];
+	bool abs = !(m->lutAbs & BIT(id*4+1));
+	return lutLookup(lut, x, abs, twoSided) * scales[(m->lutScale >> (id*4)) & 7];
+}
+
+void LightModel_Eval(const C3D_LightModel* m, u32* primary, u32* secondary,
+	const float* px, const float* py, const float* pz,
+	const float* nx, const float* ny, const float* nz, int count)
+{
+	int i, j, k;
+	Light lights[8];
+	int numLights = (m->numLights & 7) + 1;
+
+	// LUTs the configuration layer reads, minus disabled and missing ones
+	u32 layer = (m->config[0] >> 4) & 0xF;
+	u32 enabled = layerLuts[layer > 7 ? 7 : layer];
+	for (k = 0; k < 8; k ++)
+		if ((m->config[1] & BIT(16+k)) || !m->luts[k])
+			enabled &= ~BIT(k);
+	enabled &= ~(BIT(LUT_SP) | BIT(LUT_DA)); // Handled per light
+
+	float globalAmbient[3];
+	unpackColor(globalAmbient, m->ambient);
+
+	for (k = 0; k < numLights; k ++)
+	{
+		int id = (m->permutation >> (k*4)) & 7;
+		const C3D_LightModelLight* ml = &m->lights[id];
+		Light* l = &lights[k];
+
+		unpackColor(l->diffuse, ml->diffuse);
+		unpackColor(l->ambient, ml->ambient);
+		unpackColor(l->specular0, ml->specular0);
+		unpackColor(l->specular1, ml->specular1);
+		for (j = 0; j < 3; j ++)
+		{
+			l->pos[j] = C3Di_FloatToF32(ml->position[j], 10, 5, 15);
+			l->spotDir[j] = (float)((s32)((u32)ml->spotDir[j] << 19) >> 19) / 2048.0f;
+		}
+		l->distBias  = C3Di_FloatToF32(ml->distAttnBias, 12, 7, 63);
+		l->distScale = C3Di_FloatToF32(ml->distAttnScale, 12, 7, 63);
+
+		bool spot = !(m->config[1] & BIT(8+id)) && (layerLuts[layer > 7 ? 7 : layer] & BIT(LUT_SP));
+		l->lutSP = spot ? ml->lutSP : NULL;
+		l->lutDA = !(m->config[1] & BIT(24+id)) ? ml->lutDA : NULL;
+
+		l->directional = ml->config & BIT(0);
+		l->twoSided    = (ml->config & BIT(1)) != 0;
+		l->geo0        = (ml->config & BIT(2)) != 0;
+		l->geo1        = (ml->config & BIT(3)) != 0;
+	}
+
+	bool clampHighlights = (m->config[0] & BIT(27)) != 0;
+	bool fresnelPri = (m->config[0] & BIT(2)) != 0, fresnelSec = (m->config[0] & BIT(3)) != 0;
+
+	for (i = 0; i < count; i ++)
+	{
+		Vec view = { -px[i], -py[i], -pz[i] };
+		Vec n = normalize((Vec){ nx[i], ny[i], nz[i] });
+		Vec v = normalize(view);
+
+		float diffuse[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		float specular[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+		for (k = 0; k < numLights; k ++)
+		{
+			const Light* l = &lights[k];
+			Vec lv = { l->pos[0], l->pos[1], l->pos[2] };
+			if (!l->directional)
+			{
+				lv.x += view.x; lv.y += view.y; lv.z += view.z;
+			}
+			float dist = sqrtf(dot(lv, lv));
+			Vec lN = normalize(lv);
+			Vec h = { lN.x + v.x, lN.y + v.y, lN.z + v.z };
+			Vec hN = normalize(h);
+
+			float nl = dot(lN, n);
+			nl = l->twoSided ? fabsf(nl) : fmaxf(nl, 0.0f);
+
+			// Dot products selectable as LUT inputs, in GPU_LIGHTLUTINPUT order
+			Vec spotDir = { l->spotDir[0], l->spotDir[1], l->spotDir[2] };
+			float inputs[8] = { dot(n, hN), dot(v, hN), dot(n, v), dot(lN, n), dot(lN, spotDir), 0.0f, 0.0f, 0.0f };
+
+			float distAtten = 1.0f, spotAtten = 1.0f;
+			if (l->lutDA)
+			{
+				float x = l->distScale*dist + l->distBias;
+				x = x < 0.0f ? 0.0f : x > 1.0f ? 1.0f : x;
+				float f = floorf(x*256.0f);
+				int index = f > 255.0f ? 255 : (int)f;
+				distAtten = lutSample(l->lutDA, index, x*256.0f - index);
+			}
+			if (l->lutSP)
+				spotAtten = lutTerm(m, l->lutSP, LUT_SP, inputs, l->twoSided);
+
+			float geo = 1.0f;
+			if (l->geo0 || l->geo1)
+			{
+				float hh = dot(h, h);
+				geo = hh == 0.0f ? 0.0f : fminf(nl / hh, 1.0f);
+			}
+
+			float d0 = (enabled & BIT(LUT_D0)) ? lutTerm(m, m->luts[LUT_D0], LUT_D0, inputs, l->twoSided) : 1.0f;
+			float d1 = (enabled & BIT(LUT_D1)) ? lutTerm(m, m->luts[LUT_D1], LUT_D1, inputs, l->twoSided) : 1.0f;
+			float refl[3];
+			refl[0] = (enabled & BIT(LUT_RR)) ? lutTerm(m, m->luts[LUT_RR], LUT_RR, inputs, l->twoSided) : 1.0f;
+			refl[1] = (enabled & BIT(LUT_RG)) ? lutTerm(m, m->luts[LUT_RG], LUT_RG, inputs, l->twoSided) : refl[0];
+			refl[2] = (enabled & BIT(LUT_RB)) ? lutTerm(m, m->luts[LUT_RB], LUT_RB, inputs, l->twoSided) : refl[0];
+
+			if (enabled & BIT(LUT_FR))
+			{
+				float fr = lutTerm(m, m->luts[LUT_FR], LUT_FR, inputs, l->twoSided);
+				if (fresnelPri) diffuse[3] = fr;
+				if (fresnelSec) specular[3] = fr;
+			}
+
+			float atten = distAtten*spotAtten;
+			float highlight = (clampHighlights && nl <= 0.0f) ? 0.0f : atten;
+			float s0 = d0 * (l->geo0 ? geo : 1.0f);
+			float s1 = d1 * (l->geo1 ? geo : 1.0f);
+			for (j = 0; j < 3; j ++)
+			{
+				diffuse[j] += (l->diffuse[j]*nl + l->ambient[j])*atten;
+				specular[j] += (l->specular0[j]*s0 + l->specular1[j]*refl[j]*s1)*highlight;
+			}
+		}
+
+		for (j = 0; j < 3; j ++)
+			diffuse[j] += globalAmbient[j];
+
+		if (!secondary)
+			for (j = 0; j < 3; j ++)
+				diffuse[j] += specular[j];
+
+		primary[i] = toByte(diffuse[0]) | (toByte(diffuse[1]) << 8) | (toByte(diffuse[2]) << 16) | ((u32)toByte(diffuse[3]) << 24);
+		if (secondary)
+			secondary[i] = toByte(specular[0]) | (toByte(specular[1]) << 8) | (toByte(specular[2]) << 16) | ((u32)toByte(specular[3]) << 24);
+	}
+}
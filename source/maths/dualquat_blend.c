@@ -0,0 +1,19 @@
+#include <c3d/maths.h>
+
+C3D_FDualQuat DualQuat_Blend(const C3D_FDualQuat* dq, const float* weights, int count)
+{
+	int i;
+	if (count <= 0)
+		return DualQuat_Identity();
+
+	C3D_FDualQuat sum = { Quat_New(0.0f, 0.0f, 0.0f, 0.0f), Quat_New(0.0f, 0.0f, 0.0f, 0.0f) };
+	for (i = 0; i < count; i ++)
+	{
+		// q and -q are the same rotation, keep all of them in the first one's hemisphere
+		float w = Quat_Dot(dq[0].real, dq[i].real) < 0.0f ? -weights[i] : weights[i];
+		sum.real = Quat_Add(sum.real, Quat_Scale(dq[i].real, w));
+		sum.dual = Quat_Add(sum.dual, Quat_Scale(dq[i].dual, w));
+	}
+
+	return DualQuat_Normalize(sum);
+}
@@ -0,0 +1,6 @@
+#include <c3d/maths.h>
+
+C3D_FDualQuat DualQuat_FromMtx(const C3D_Mtx* m)
+{
+	return DualQuat_FromRotTrans(Quat_FromMtx(m), FVec3_New(m->r[0].w, m->r[1].w, m->r[2].w));
+}
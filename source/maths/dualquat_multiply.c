@@ -0,0 +1,10 @@
+#include <c3d/maths.h>
+
+C3D_FDualQuat DualQuat_Multiply(C3D_FDualQuat lhs, C3D_FDualQuat rhs)
+{
+	// (a + εb)(c + εd) = ac + ε(ad + bc), since ε² = 0
+	C3D_FDualQuat dq;
+	dq.real = Quat_Multiply(lhs.real, rhs.real);
+	dq.dual = Quat_Add(Quat_Multiply(lhs.real, rhs.dual), Quat_Multiply(lhs.dual, rhs.real));
+	return dq;
+}
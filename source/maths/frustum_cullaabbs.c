@@ -0,0 +1,88 @@
+#include <c3d/maths.h>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+int Frustum_CullAABBs(const C3D_Frustum* f, const C3D_AABB* boxes, int count, u32* visible, u32* culled)
+{
+	int i = 0, j, numVisible = 0, numCulled = 0;
+
+#if defined(__SSE__)
+	// Host builds test four boxes at once. The arithmetic matches Frustum_TestAABB
+	// operation for operation, so both paths classify every box identically.
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 half = _mm_set1_ps(0.5f);
+		__m128 cx, cy, cz, cw, ex, ey, ez, ew;
+
+		cw = _mm_loadu_ps(boxes[i+0].min.c);
+		cz = _mm_loadu_ps(boxes[i+1].min.c);
+		cy = _mm_loadu_ps(boxes[i+2].min.c);
+		cx = _mm_loadu_ps(boxes[i+3].min.c);
+		ew = _mm_loadu_ps(boxes[i+0].max.c);
+		ez = _mm_loadu_ps(boxes[i+1].max.c);
+		ey = _mm_loadu_ps(boxes[i+2].max.c);
+		ex = _mm_loadu_ps(boxes[i+3].max.c);
+		_MM_TRANSPOSE4_PS(cw, cz, cy, cx); // C3D_FVec is stored as w,z,y,x
+		_MM_TRANSPOSE4_PS(ew, ez, ey, ex);
+		(void)cw; (void)ew;
+
+		// Min/max are turned into center/extent in place
+		__m128 tx = cx, ty = cy, tz = cz;
+		cx = _mm_mul_ps(_mm_add_ps(tx, ex), half);
+		cy = _mm_mul_ps(_mm_add_ps(ty, ey), half);
+		cz = _mm_mul_ps(_mm_add_ps(tz, ez), half);
+		ex = _mm_mul_ps(_mm_sub_ps(ex, tx), half);
+		ey = _mm_mul_ps(_mm_sub_ps(ey, ty), half);
+		ez = _mm_mul_ps(_mm_sub_ps(ez, tz), half);
+
+		__m128 out = _mm_setzero_ps();
+		for (j = 0; j < 6; ++j)
+		{
+			const C3D_FVec* p = &f->planes[j];
+			__m128 px = _mm_set1_ps(p->x), py = _mm_set1_ps(p->y), pz = _mm_set1_ps(p->z);
+
+			__m128 r = _mm_mul_ps(_mm_set1_ps(fabsf(p->x)), ex);
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(fabsf(p->y)), ey));
+			r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(fabsf(p->z)), ez));
+
+			__m128 d = _mm_mul_ps(px, cx);
+			d = _mm_add_ps(d, _mm_mul_ps(py, cy));
+			d = _mm_add_ps(d, _mm_mul_ps(pz, cz));
+			d = _mm_add_ps(d, _mm_set1_ps(p->w));
+			out = _mm_or_ps(out, _mm_cmplt_ps(d, _mm_sub_ps(_mm_setzero_ps(), r)));
+		}
+
+		int mask = _mm_movemask_ps(out);
+		for (j = 0; j < 4; ++j)
+		{
+			if (mask & (1 << j))
+			{
+				if (culled) culled[numCulled] = i + j;
+				numCulled++;
+			}
+			else
+			{
+				if (visible) visible[numVisible] = i + j;
+				numVisible++;
+			}
+		}
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		if (Frustum_TestAABB(f, &boxes[i]))
+		{
+			if (visible) visible[numVisible] = i;
+			numVisible++;
+		}
+		else
+		{
+			if (culled) culled[numCulled] = i;
+			numCulled++;
+		}
+	}
+
+	return numVisible;
+}
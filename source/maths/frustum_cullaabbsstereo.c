@@ -0,0 +1,41 @@
+#include <c3d/maths.h>
+
+static bool testAABB(const C3D_Frustum* f, u8 planes, C3D_FVec c, C3D_FVec e)
+{
+	int i;
+	for (i = 0; i < 6; ++i)
+	{
+		if (!(planes & (1 << i))) continue;
+		C3D_FVec n = f->planes[i];
+		float r = fabsf(n.x)*e.x + fabsf(n.y)*e.y + fabsf(n.z)*e.z;
+		if (Frustum_PlaneDistance(n, c) < -r)
+			return false;
+	}
+	return true;
+}
+
+int Frustum_CullAABBsStereo(const C3D_StereoFrustum* f, const C3D_AABB* boxes, int count, u8* masks)
+{
+	int i, numVisible = 0;
+	u8 eyePlanes = ~f->sharedPlanes & 0x3F;
+
+	for (i = 0; i < count; ++i)
+	{
+		C3D_FVec c = FVec3_Scale(FVec3_Add(boxes[i].min, boxes[i].max), 0.5f);
+		C3D_FVec e = FVec3_Scale(FVec3_Subtract(boxes[i].max, boxes[i].min), 0.5f);
+		u8 mask = 0;
+		if (testAABB(&f->both, 0x3F, c, e))
+		{
+			// Planes shared by both eyes were already tested against the union
+			if (testAABB(&f->eye[0], eyePlanes, c, e))
+				mask |= C3D_STEREO_LEFT;
+			if (testAABB(&f->eye[1], eyePlanes, c, e))
+				mask |= C3D_STEREO_RIGHT;
+		}
+		masks[i] = mask;
+		if (mask)
+			numVisible++;
+	}
+
+	return numVisible;
+}
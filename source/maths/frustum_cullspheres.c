@@ -0,0 +1,65 @@
+#include <c3d/maths.h>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+int Frustum_CullSpheres(const C3D_Frustum* f, const C3D_FVec* spheres, int count, u32* visible, u32* culled)
+{
+	int i = 0, j, numVisible = 0, numCulled = 0;
+
+#if defined(__SSE__)
+	// Host builds test four spheres at once. The arithmetic matches Frustum_TestSphere
+	// operation for operation, so both paths classify every sphere identically.
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 r = _mm_loadu_ps(spheres[i+0].c);
+		__m128 z = _mm_loadu_ps(spheres[i+1].c);
+		__m128 y = _mm_loadu_ps(spheres[i+2].c);
+		__m128 x = _mm_loadu_ps(spheres[i+3].c);
+		_MM_TRANSPOSE4_PS(r, z, y, x); // C3D_FVec is stored as w,z,y,x
+
+		__m128 nr = _mm_sub_ps(_mm_setzero_ps(), r);
+		__m128 out = _mm_setzero_ps();
+		for (j = 0; j < 6; ++j)
+		{
+			const C3D_FVec* p = &f->planes[j];
+			__m128 d = _mm_mul_ps(_mm_set1_ps(p->x), x);
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(p->y), y));
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(p->z), z));
+			d = _mm_add_ps(d, _mm_set1_ps(p->w));
+			out = _mm_or_ps(out, _mm_cmplt_ps(d, nr));
+		}
+
+		int mask = _mm_movemask_ps(out);
+		for (j = 0; j < 4; ++j)
+		{
+			if (mask & (1 << j))
+			{
+				if (culled) culled[numCulled] = i + j;
+				numCulled++;
+			}
+			else
+			{
+				if (visible) visible[numVisible] = i + j;
+				numVisible++;
+			}
+		}
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		if (Frustum_TestSphere(f, spheres[i]))
+		{
+			if (visible) visible[numVisible] = i;
+			numVisible++;
+		}
+		else
+		{
+			if (culled) culled[numCulled] = i;
+			numCulled++;
+		}
+	}
+
+	return numVisible;
+}
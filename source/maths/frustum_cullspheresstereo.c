@@ -0,0 +1,34 @@
+#include <c3d/maths.h>
+
+static bool testSphere(const C3D_Frustum* f, u8 planes, C3D_FVec s)
+{
+	int i;
+	for (i = 0; i < 6; ++i)
+		if ((planes & (1 << i)) && Frustum_PlaneDistance(f->planes[i], s) < -s.w)
+			return false;
+	return true;
+}
+
+int Frustum_CullSpheresStereo(const C3D_StereoFrustum* f, const C3D_FVec* spheres, int count, u8* masks)
+{
+	int i, numVisible = 0;
+	u8 eyePlanes = ~f->sharedPlanes & 0x3F;
+
+	for (i = 0; i < count; ++i)
+	{
+		u8 mask = 0;
+		if (Frustum_TestSphere(&f->both, spheres[i]))
+		{
+			// Planes shared by both eyes were already tested against the union
+			if (testSphere(&f->eye[0], eyePlanes, spheres[i]))
+				mask |= C3D_STEREO_LEFT;
+			if (testSphere(&f->eye[1], eyePlanes, spheres[i]))
+				mask |= C3D_STEREO_RIGHT;
+		}
+		masks[i] = mask;
+		if (mask)
+			numVisible++;
+	}
+
+	return numVisible;
+}
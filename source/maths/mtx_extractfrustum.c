@@ -0,0 +1,22 @@
+#include <c3d/maths.h>
+
+void Mtx_ExtractFrustum(C3D_Frustum* out, const C3D_Mtx* mtx)
+{
+	// PICA clip space is -w <= x <= w, -w <= y <= w and -w <= z <= 0, so each
+	// plane is a sum of the W row and one of the other rows (Gribb & Hartmann).
+	// This holds for the tilted projections too, which only swap the X and Y rows.
+	out->planes[0] = FVec4_Add(mtx->r[3], mtx->r[0]);
+	out->planes[1] = FVec4_Subtract(mtx->r[3], mtx->r[0]);
+	out->planes[2] = FVec4_Add(mtx->r[3], mtx->r[1]);
+	out->planes[3] = FVec4_Subtract(mtx->r[3], mtx->r[1]);
+	out->planes[4] = FVec4_Add(mtx->r[3], mtx->r[2]);
+	out->planes[5] = FVec4_Negate(mtx->r[2]);
+
+	int i;
+	for (i = 0; i < 6; ++i)
+	{
+		float len = FVec3_Magnitude(out->planes[i]);
+		if (len > 0.0f)
+			out->planes[i] = FVec4_Scale(out->planes[i], 1.0f / len);
+	}
+}
@@ -0,0 +1,130 @@
+#include <float.h>
+#include <c3d/maths.h>
+
+// Corner i of a clip volume has x = ±1 (bit 0), y = ±1 (bit 1) and z = -1 or 0 (bit 2)
+static bool getCorners(C3D_FVec* out, const C3D_Mtx* mtx)
+{
+	C3D_Mtx inv;
+	int i;
+
+	Mtx_Copy(&inv, mtx);
+	if (Mtx_Inverse(&inv) == 0.0f)
+		return false;
+
+	for (i = 0; i < 8; ++i)
+	{
+		C3D_FVec c = FVec4_New(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 0.0f : -1.0f, 1.0f);
+		out[i] = FVec4_PerspDivide(Mtx_MultiplyFVec4(&inv, c));
+	}
+	return true;
+}
+
+static bool isFaceCorner(int plane, int corner)
+{
+	switch (plane)
+	{
+		case 0: return !(corner & 1);
+		case 1: return   corner & 1;
+		case 2: return !(corner & 2);
+		case 3: return   corner & 2;
+		case 4: return !(corner & 4);
+		default: return  corner & 4;
+	}
+}
+
+// Plane through the near edge of one eye's face and the middle of the other eye's far edge
+static C3D_FVec crossPlane(int plane, const C3D_FVec* nearCorners, const C3D_FVec* farCorners, C3D_FVec center)
+{
+	C3D_FVec p[2], q = FVec3_New(0.0f, 0.0f, 0.0f);
+	int i, n = 0;
+	for (i = 0; i < 8; ++i)
+	{
+		if (!isFaceCorner(plane, i)) continue;
+		if (i & 4)
+			q = FVec3_Add(q, FVec3_Scale(farCorners[i], 0.5f));
+		else
+			p[n++] = nearCorners[i];
+	}
+
+	C3D_FVec n3 = FVec3_Cross(FVec3_Subtract(p[1], p[0]), FVec3_Subtract(q, p[0]));
+	float len = FVec3_Magnitude(n3);
+	if (len <= 0.0f)
+		return FVec4_New(0.0f, 0.0f, 0.0f, 1.0f);
+
+	n3 = FVec3_Scale(n3, 1.0f / len);
+	C3D_FVec res = FVec4_New(n3.x, n3.y, n3.z, -FVec3_Dot(n3, p[0]));
+	return Frustum_PlaneDistance(res, center) < 0.0f ? FVec4_Negate(res) : res;
+}
+
+void Mtx_ExtractFrustumStereo(C3D_StereoFrustum* out, const C3D_Mtx* left, const C3D_Mtx* right)
+{
+	C3D_FVec corners[16], center = FVec3_New(0.0f, 0.0f, 0.0f);
+	int i, j, k;
+	float size = 0.0f;
+
+	Mtx_ExtractFrustum(&out->eye[0], left);
+	Mtx_ExtractFrustum(&out->eye[1], right);
+	out->sharedPlanes = 0;
+
+	if (!getCorners(&corners[0], left) || !getCorners(&corners[8], right))
+	{
+		// Let the union test pass everything and leave the work to the eye tests
+		for (j = 0; j < 6; ++j)
+			out->both.planes[j] = FVec4_New(0.0f, 0.0f, 0.0f, 1.0f);
+		return;
+	}
+
+	for (i = 0; i < 16; ++i)
+	{
+		center = FVec3_Add(center, FVec3_Scale(corners[i], 1.0f / 16.0f));
+		size = fmaxf(size, fmaxf(fabsf(corners[i].x), fmaxf(fabsf(corners[i].y), fabsf(corners[i].z))));
+	}
+	float eps = size * 1e-5f;
+
+	for (j = 0; j < 6; ++j)
+	{
+		C3D_FVec a = out->eye[0].planes[j], b = out->eye[1].planes[j];
+		if (fabsf(a.x-b.x) <= 1e-5f && fabsf(a.y-b.y) <= 1e-5f && fabsf(a.z-b.z) <= 1e-5f && fabsf(a.w-b.w) <= eps)
+		{
+			out->sharedPlanes |= 1 << j;
+			out->both.planes[j] = a;
+			continue;
+		}
+
+		// Candidates are both eye planes and, for the side planes, the planes joining
+		// one eye's near edge with the other eye's far edge, which bound the union
+		// tightly when the eye frusta cross over before the far plane. Each one is
+		// pushed out until it contains every corner and the tightest one is kept.
+		C3D_FVec cand[4];
+		int numCand = 2;
+		cand[0] = a;
+		cand[1] = b;
+		if (j < 4)
+		{
+			cand[numCand++] = crossPlane(j, &corners[0], &corners[8], center);
+			cand[numCand++] = crossPlane(j, &corners[8], &corners[0], center);
+		}
+
+		float best = FLT_MAX;
+		for (k = 0; k < numCand; ++k)
+		{
+			float minDist = FLT_MAX, sum = 0.0f;
+			for (i = 0; i < 16; ++i)
+			{
+				float d = Frustum_PlaneDistance(cand[k], corners[i]);
+				minDist = fminf(minDist, d);
+				sum += d;
+			}
+			if (minDist < 0.0f)
+			{
+				cand[k].w -= minDist;
+				sum -= 16.0f*minDist;
+			}
+			if (sum < best)
+			{
+				best = sum;
+				out->both.planes[j] = cand[k];
+			}
+		}
+	}
+}
@@ -0,0 +1,11 @@
+#include <c3d/maths.h>
+
+void Mtx_FromDualQuat(C3D_Mtx* m, C3D_FDualQuat dq)
+{
+	C3D_FVec t = DualQuat_Translation(dq);
+
+	Mtx_FromQuat(m, dq.real);
+	m->r[0].w = t.x;
+	m->r[1].w = t.y;
+	m->r[2].w = t.z;
+}
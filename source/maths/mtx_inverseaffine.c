@@ -0,0 +1,38 @@
+#include <float.h>
+#include <c3d/maths.h>
+
+float Mtx_InverseAffine(C3D_Mtx* out)
+{
+	// [ L t ]^-1   [ L^-1  -L^-1*t ]
+	// [ 0 1 ]    = [ 0     1       ]
+	// so only the 3x3 linear part needs a cofactor expansion
+	float a = out->r[0].x, b = out->r[0].y, c = out->r[0].z;
+	float d = out->r[1].x, e = out->r[1].y, f = out->r[1].z;
+	float g = out->r[2].x, h = out->r[2].y, i = out->r[2].z;
+
+	float A =   e*i - f*h;
+	float B = -(d*i - f*g);
+	float C =   d*h - e*g;
+
+	float det = a*A + b*B + c*C;
+	if (fabsf(det) < FLT_EPSILON)
+		//Returns 0.0f if we find the determinant is less than +/- FLT_EPSILON.
+		return 0.0f;
+
+	float inv = 1.0f / det;
+	C3D_FVec r0 = FVec3_New( A*inv, -(b*i - c*h)*inv,  (b*f - c*e)*inv);
+	C3D_FVec r1 = FVec3_New( B*inv,  (a*i - c*g)*inv, -(a*f - c*d)*inv);
+	C3D_FVec r2 = FVec3_New( C*inv, -(a*h - b*g)*inv,  (a*e - b*d)*inv);
+	C3D_FVec t  = FVec3_New(out->r[0].w, out->r[1].w, out->r[2].w);
+
+	r0.w = -FVec3_Dot(r0, t);
+	r1.w = -FVec3_Dot(r1, t);
+	r2.w = -FVec3_Dot(r2, t);
+
+	out->r[0] = r0;
+	out->r[1] = r1;
+	out->r[2] = r2;
+	out->r[3] = FVec4_New(0.0f, 0.0f, 0.0f, 1.0f);
+
+	return det;
+}
@@ -0,0 +1,20 @@
+#include <c3d/maths.h>
+
+void Mtx_InverseRigid(C3D_Mtx* out)
+{
+	// The inverse of an orthonormal rotation is its transpose, and the
+	// translation is moved back along the transposed axes
+	C3D_FVec t = FVec3_New(out->r[0].w, out->r[1].w, out->r[2].w);
+	C3D_FVec r0 = FVec3_New(out->r[0].x, out->r[1].x, out->r[2].x);
+	C3D_FVec r1 = FVec3_New(out->r[0].y, out->r[1].y, out->r[2].y);
+	C3D_FVec r2 = FVec3_New(out->r[0].z, out->r[1].z, out->r[2].z);
+
+	r0.w = -FVec3_Dot(r0, t);
+	r1.w = -FVec3_Dot(r1, t);
+	r2.w = -FVec3_Dot(r2, t);
+
+	out->r[0] = r0;
+	out->r[1] = r1;
+	out->r[2] = r2;
+	out->r[3] = FVec4_New(0.0f, 0.0f, 0.0f, 1.0f);
+}
@@ -0,0 +1,26 @@
+#include <c3d/maths.h>
+
+void Mtx_MultiplyAffine(C3D_Mtx* out, const C3D_Mtx* a, const C3D_Mtx* b)
+{
+	// if out is a or b, then we need to avoid overwriting them
+	if(out == a || out == b)
+	{
+		C3D_Mtx tmp;
+		Mtx_MultiplyAffine(&tmp, a, b);
+		Mtx_Copy(out, &tmp);
+		return;
+	}
+
+	// Same as Mtx_Multiply with the bottom rows of a and b taken as 0,0,0,1:
+	// 36 multiplies instead of 64, and the bottom row of the product is known
+	int j;
+	for (j = 0; j < 3; ++j)
+	{
+		float x = a->r[j].x, y = a->r[j].y, z = a->r[j].z;
+		out->r[j].x = x*b->r[0].x + y*b->r[1].x + z*b->r[2].x;
+		out->r[j].y = x*b->r[0].y + y*b->r[1].y + z*b->r[2].y;
+		out->r[j].z = x*b->r[0].z + y*b->r[1].z + z*b->r[2].z;
+		out->r[j].w = x*b->r[0].w + y*b->r[1].w + z*b->r[2].w + a->r[j].w;
+	}
+	out->r[3] = FVec4_New(0.0f, 0.0f, 0.0f, 1.0f);
+}
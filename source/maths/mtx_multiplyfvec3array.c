@@ -0,0 +1,34 @@
+#include <c3d/maths.h>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+void Mtx_MultiplyFVec3Array(const C3D_Mtx* mtx, C3D_FVec* out, const C3D_FVec* in, int count)
+{
+	int i = 0;
+
+#if defined(__SSE__)
+	// See Mtx_MultiplyFVec4Array. The w lane is masked off rather than computed
+	// from zero coefficients, so an infinite input cannot leave a NaN in it.
+	static const union { u32 u[4]; float f[4]; } xyzMask = { { 0, ~0u, ~0u, ~0u } };
+	__m128 mask = _mm_loadu_ps(xyzMask.f);
+	__m128 cx = _mm_set_ps(mtx->r[0].x, mtx->r[1].x, mtx->r[2].x, 0.0f);
+	__m128 cy = _mm_set_ps(mtx->r[0].y, mtx->r[1].y, mtx->r[2].y, 0.0f);
+	__m128 cz = _mm_set_ps(mtx->r[0].z, mtx->r[1].z, mtx->r[2].z, 0.0f);
+	for (; i < count; ++i)
+	{
+		__m128 v = _mm_loadu_ps(in[i].c);
+		__m128 r = _mm_mul_ps(cx, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3,3,3,3)));
+		r = _mm_add_ps(r, _mm_mul_ps(cy, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2,2,2,2))));
+		r = _mm_add_ps(r, _mm_mul_ps(cz, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1,1,1,1))));
+		_mm_storeu_ps(out[i].c, _mm_and_ps(r, mask));
+	}
+#else
+	C3D_FVec r0 = mtx->r[0], r1 = mtx->r[1], r2 = mtx->r[2];
+	for (; i < count; ++i)
+	{
+		C3D_FVec v = in[i];
+		out[i] = FVec3_New(FVec3_Dot(r0, v), FVec3_Dot(r1, v), FVec3_Dot(r2, v));
+	}
+#endif
+}
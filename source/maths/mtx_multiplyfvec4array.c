@@ -0,0 +1,36 @@
+#include <c3d/maths.h>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+void Mtx_MultiplyFVec4Array(const C3D_Mtx* mtx, C3D_FVec* out, const C3D_FVec* in, int count)
+{
+	int i = 0;
+
+#if defined(__SSE__)
+	// Host builds keep the matrix columns in registers and accumulate them scaled by
+	// each component, in the same order as FVec4_Dot so both paths agree exactly.
+	// C3D_FVec is stored as w,z,y,x, so a column holds the rows in reverse order.
+	__m128 cx = _mm_set_ps(mtx->r[0].x, mtx->r[1].x, mtx->r[2].x, mtx->r[3].x);
+	__m128 cy = _mm_set_ps(mtx->r[0].y, mtx->r[1].y, mtx->r[2].y, mtx->r[3].y);
+	__m128 cz = _mm_set_ps(mtx->r[0].z, mtx->r[1].z, mtx->r[2].z, mtx->r[3].z);
+	__m128 cw = _mm_set_ps(mtx->r[0].w, mtx->r[1].w, mtx->r[2].w, mtx->r[3].w);
+	for (; i < count; ++i)
+	{
+		__m128 v = _mm_loadu_ps(in[i].c);
+		__m128 r = _mm_mul_ps(cx, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3,3,3,3)));
+		r = _mm_add_ps(r, _mm_mul_ps(cy, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2,2,2,2))));
+		r = _mm_add_ps(r, _mm_mul_ps(cz, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1,1,1,1))));
+		r = _mm_add_ps(r, _mm_mul_ps(cw, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0,0,0,0))));
+		_mm_storeu_ps(out[i].c, r);
+	}
+#else
+	// Keep the matrix in locals so the compiler does not reload it after every store
+	C3D_FVec r0 = mtx->r[0], r1 = mtx->r[1], r2 = mtx->r[2], r3 = mtx->r[3];
+	for (; i < count; ++i)
+	{
+		C3D_FVec v = in[i];
+		out[i] = FVec4_New(FVec4_Dot(r0, v), FVec4_Dot(r1, v), FVec4_Dot(r2, v), FVec4_Dot(r3, v));
+	}
+#endif
+}
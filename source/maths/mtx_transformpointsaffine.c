@@ -0,0 +1,50 @@
+#include <c3d/maths.h>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+void Mtx_TransformPointsAffine(const C3D_Mtx* mtx, float* out, const float* in, int count)
+{
+	int i = 0;
+	float m00 = mtx->r[0].x, m01 = mtx->r[0].y, m02 = mtx->r[0].z, m03 = mtx->r[0].w;
+	float m10 = mtx->r[1].x, m11 = mtx->r[1].y, m12 = mtx->r[1].z, m13 = mtx->r[1].w;
+	float m20 = mtx->r[2].x, m21 = mtx->r[2].y, m22 = mtx->r[2].z, m23 = mtx->r[2].w;
+
+#if defined(__SSE__)
+	// Host builds transform four points at once: 12 packed floats are shuffled into
+	// x, y and z vectors, transformed, and interleaved again on the way out.
+	__m128 a00 = _mm_set1_ps(m00), a01 = _mm_set1_ps(m01), a02 = _mm_set1_ps(m02), a03 = _mm_set1_ps(m03);
+	__m128 a10 = _mm_set1_ps(m10), a11 = _mm_set1_ps(m11), a12 = _mm_set1_ps(m12), a13 = _mm_set1_ps(m13);
+	__m128 a20 = _mm_set1_ps(m20), a21 = _mm_set1_ps(m21), a22 = _mm_set1_ps(m22), a23 = _mm_set1_ps(m23);
+	for (; i + 4 <= count; i += 4, in += 12, out += 12)
+	{
+		__m128 a = _mm_loadu_ps(in+0); // x0 y0 z0 x1
+		__m128 b = _mm_loadu_ps(in+4); // y1 z1 x2 y2
+		__m128 c = _mm_loadu_ps(in+8); // z2 x3 y3 z3
+
+		__m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1,1,2,2)), _MM_SHUFFLE(2,0,3,0));
+		__m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0,0,1,1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2,2,3,3)), _MM_SHUFFLE(2,0,2,0));
+		__m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1,1,2,2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3,3,0,0)), _MM_SHUFFLE(2,0,2,0));
+
+		__m128 tx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a00, x), _mm_mul_ps(a01, y)), _mm_mul_ps(a02, z)), a03);
+		__m128 ty = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a10, x), _mm_mul_ps(a11, y)), _mm_mul_ps(a12, z)), a13);
+		__m128 tz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a20, x), _mm_mul_ps(a21, y)), _mm_mul_ps(a22, z)), a23);
+
+		a = _mm_shuffle_ps(_mm_shuffle_ps(tx, ty, _MM_SHUFFLE(0,0,0,0)), _mm_shuffle_ps(tz, tx, _MM_SHUFFLE(1,1,0,0)), _MM_SHUFFLE(2,0,2,0));
+		b = _mm_shuffle_ps(_mm_shuffle_ps(ty, tz, _MM_SHUFFLE(1,1,1,1)), _mm_shuffle_ps(tx, ty, _MM_SHUFFLE(2,2,2,2)), _MM_SHUFFLE(2,0,2,0));
+		c = _mm_shuffle_ps(_mm_shuffle_ps(tz, tx, _MM_SHUFFLE(3,3,2,2)), _mm_shuffle_ps(ty, tz, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(2,0,2,0));
+		_mm_storeu_ps(out+0, a);
+		_mm_storeu_ps(out+4, b);
+		_mm_storeu_ps(out+8, c);
+	}
+#endif
+
+	// Same arithmetic as Mtx_MultiplyFVecH, without the projective row
+	for (; i < count; ++i, in += 3, out += 3)
+	{
+		float x = in[0], y = in[1], z = in[2];
+		out[0] = m00*x + m01*y + m02*z + m03;
+		out[1] = m10*x + m11*y + m12*z + m13;
+		out[2] = m20*x + m21*y + m22*z + m23;
+	}
+}
@@ -0,0 +1,35 @@
+#include <c3d/maths.h>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+void Mtx_TransformPointsAffineSoA(const C3D_Mtx* mtx, float* outX, float* outY, float* outZ, const float* inX, const float* inY, const float* inZ, int count)
+{
+	int i = 0;
+	float m00 = mtx->r[0].x, m01 = mtx->r[0].y, m02 = mtx->r[0].z, m03 = mtx->r[0].w;
+	float m10 = mtx->r[1].x, m11 = mtx->r[1].y, m12 = mtx->r[1].z, m13 = mtx->r[1].w;
+	float m20 = mtx->r[2].x, m21 = mtx->r[2].y, m22 = mtx->r[2].z, m23 = mtx->r[2].w;
+
+#if defined(__SSE__)
+	__m128 a00 = _mm_set1_ps(m00), a01 = _mm_set1_ps(m01), a02 = _mm_set1_ps(m02), a03 = _mm_set1_ps(m03);
+	__m128 a10 = _mm_set1_ps(m10), a11 = _mm_set1_ps(m11), a12 = _mm_set1_ps(m12), a13 = _mm_set1_ps(m13);
+	__m128 a20 = _mm_set1_ps(m20), a21 = _mm_set1_ps(m21), a22 = _mm_set1_ps(m22), a23 = _mm_set1_ps(m23);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(inX+i);
+		__m128 y = _mm_loadu_ps(inY+i);
+		__m128 z = _mm_loadu_ps(inZ+i);
+		_mm_storeu_ps(outX+i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a00, x), _mm_mul_ps(a01, y)), _mm_mul_ps(a02, z)), a03));
+		_mm_storeu_ps(outY+i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a10, x), _mm_mul_ps(a11, y)), _mm_mul_ps(a12, z)), a13));
+		_mm_storeu_ps(outZ+i, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a20, x), _mm_mul_ps(a21, y)), _mm_mul_ps(a22, z)), a23));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		float x = inX[i], y = inY[i], z = inZ[i];
+		outX[i] = m00*x + m01*y + m02*z + m03;
+		outY[i] = m10*x + m11*y + m12*z + m13;
+		outZ[i] = m20*x + m21*y + m22*z + m23;
+	}
+}
@@ -19,9 +19,9 @@ C3D_FQuat Quat_FromMtx(const C3D_Mtx* m)
 		sqrtTrace = sqrtf(trace + 1.0f);
 		q.w = sqrtTrace / 2.0f;
 		sqrtTrace = 0.5 / sqrtTrace;
-		q.x = (m->r[1].z - m->r[2].y) * sqrtTrace;
-		q.y = (m->r[2].x - m->r[0].z) * sqrtTrace;
-		q.z = (m->r[0].y - m->r[1].x) * sqrtTrace;
+		q.x = (m->r[2].y - m->r[1].z) * sqrtTrace;
+		q.y = (m->r[0].z - m->r[2].x) * sqrtTrace;
+		q.z = (m->r[1].x - m->r[0].y) * sqrtTrace;
 	}
 	else 
 	{
@@ -31,23 +31,23 @@ C3D_FQuat Quat_FromMtx(const C3D_Mtx* m)
 			sqrtTrace = 2.0f * sqrtf(1.0f + m->r[0].x - m->r[1].y - m->r[2].z);
 			q.w = (m->r[2].y - m->r[1].z) / sqrtTrace;
 			q.x = 0.25f * sqrtTrace;
-			q.y = (m->r[0].y - m->r[1].x) / sqrtTrace;
-			q.z = (m->r[0].z - m->r[2].x) / sqrtTrace;
+			q.y = (m->r[0].y + m->r[1].x) / sqrtTrace;
+			q.z = (m->r[0].z + m->r[2].x) / sqrtTrace;
 		}
 		else if (m->r[1].y > m->r[2].z)
 		{
 			sqrtTrace = 2.0f * sqrtf(1.0f + m->r[1].y - m->r[0].x - m->r[2].z);
 			q.w = (m->r[0].z - m->r[2].x) / sqrtTrace;
-			q.x = (m->r[0].y - m->r[1].x) / sqrtTrace;
+			q.x = (m->r[0].y + m->r[1].x) / sqrtTrace;
 			q.y = 0.25f * sqrtTrace;
-			q.z = (m->r[1].z - m->r[2].y) / sqrtTrace;
+			q.z = (m->r[1].z + m->r[2].y) / sqrtTrace;
 		}
 		else 
 		{
 			sqrtTrace = 2.0f * sqrtf(1.0f + m->r[2].z - m->r[0].x - m->r[1].y);
 			q.w = (m->r[1].x - m->r[0].y) / sqrtTrace;
-			q.x = (m->r[0].z - m->r[2].x) / sqrtTrace;
-			q.y = (m->r[1].z - m->r[2].y) / sqrtTrace;
+			q.x = (m->r[0].z + m->r[2].x) / sqrtTrace;
+			q.y = (m->r[1].z + m->r[2].y) / sqrtTrace;
 			q.z = 0.25f * sqrtTrace;
 		}
 	}
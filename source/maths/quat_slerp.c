@@ -0,0 +1,22 @@
+#include <c3d/maths.h>
+
+C3D_FQuat Quat_Slerp(C3D_FQuat a, C3D_FQuat b, float t)
+{
+	float d = Quat_Dot(a, b);
+
+	// q and -q are the same rotation, so take the shorter arc
+	if (d < 0.0f)
+	{
+		b = Quat_Negate(b);
+		d = -d;
+	}
+
+	// nearly parallel, sinf(angle) approaches zero, but nlerp is accurate here
+	if (d > 0.9995f)
+		return Quat_Nlerp(a, b, t);
+
+	float angle = acosf(d);
+	float s     = 1.0f / sinf(angle);
+
+	return Quat_Add(Quat_Scale(a, sinf((1.0f-t)*angle)*s), Quat_Scale(b, sinf(t*angle)*s));
+}
@@ -1,5 +1,6 @@
 #include <c3d/mtxstack.h>
 #include <c3d/uniforms.h>
+#include <stdlib.h>
 
 void MtxStack_Init(C3D_MtxStack* stk)
 {
@@ -41,3 +42,108 @@ void MtxStack_Update(C3D_MtxStack* stk)
 
 	stk->isDirty = false;
 }
+
+bool MvpStack_Init(C3D_MvpStack* stk, int depth)
+{
+	int i;
+	if (depth < 1) return false;
+	stk->m = (C3D_Mtx*)malloc(depth*sizeof(C3D_Mtx));
+	if (!stk->m) return false;
+
+	stk->pos = 0;
+	stk->depth = depth;
+	stk->dirty = C3D_MVPDIRTY_ALL;
+	for (i = 0; i < C3D_MVP_COUNT; i ++)
+		stk->unifPos[i] = 0xFF;
+	Mtx_Identity(&stk->proj);
+	Mtx_Identity(&stk->view);
+	Mtx_Identity(&stk->m[0]);
+	return true;
+}
+
+void MvpStack_Free(C3D_MvpStack* stk)
+{
+	free(stk->m);
+	stk->m = NULL;
+	stk->depth = 0;
+}
+
+void MvpStack_Bind(C3D_MvpStack* stk, GPU_SHADER_TYPE unifType, int which, int unifPos, int unifLen)
+{
+	if (which < 0 || which >= C3D_MVP_COUNT) return;
+	stk->unifType[which] = unifType;
+	stk->unifPos[which] = unifPos;
+	stk->unifLen[which] = unifLen;
+	stk->dirty = C3D_MVPDIRTY_ALL;
+}
+
+C3D_Mtx* MvpStack_Push(C3D_MvpStack* stk)
+{
+	if (stk->pos == (stk->depth-1)) return NULL;
+	stk->pos ++;
+	Mtx_Copy(&stk->m[stk->pos], &stk->m[stk->pos-1]);
+	return MvpStack_Cur(stk);
+}
+
+C3D_Mtx* MvpStack_Pop(C3D_MvpStack* stk)
+{
+	if (stk->pos == 0) return NULL;
+	stk->pos --;
+	return MvpStack_Cur(stk);
+}
+
+static void C3Di_MvpNormal(C3D_Mtx* out, const C3D_Mtx* modelView)
+{
+	// Only the 3x3 part transforms normals, so the translation is dropped before inverting
+	Mtx_Copy(out, modelView);
+	out->r[0].w = out->r[1].w = out->r[2].w = 0.0f;
+	if (Mtx_IsAffine(out) ? Mtx_InverseAffine(out) : Mtx_Inverse(out))
+		Mtx_Transpose(out);
+	else
+		Mtx_Copy(out, modelView); // Degenerate, keep normals as they are
+}
+
+void MvpStack_Update(C3D_MvpStack* stk)
+{
+	int i;
+	u8 dirty = stk->dirty, upload = 0;
+	if (!dirty) return;
+
+	const C3D_Mtx* model = &stk->m[stk->pos];
+
+	// Objects sharing a camera only pay for this once
+	if (dirty & (C3D_MVPDIRTY_PROJ|C3D_MVPDIRTY_VIEW))
+		Mtx_Multiply(&stk->projView, &stk->proj, &stk->view);
+	if (dirty & C3D_MVPDIRTY_PROJ)
+		upload |= BIT(C3D_MVP_PROJECTION);
+
+	if (dirty & (C3D_MVPDIRTY_VIEW|C3D_MVPDIRTY_MODEL))
+	{
+		if (Mtx_IsAffine(&stk->view) && Mtx_IsAffine(model))
+			Mtx_MultiplyAffine(&stk->modelView, &stk->view, model);
+		else
+			Mtx_Multiply(&stk->modelView, &stk->view, model);
+		upload |= BIT(C3D_MVP_MODELVIEW);
+
+		// The normal matrix is only maintained while it is bound
+		if (stk->unifPos[C3D_MVP_NORMAL] != 0xFF)
+		{
+			C3Di_MvpNormal(&stk->normal, &stk->modelView);
+			upload |= BIT(C3D_MVP_NORMAL);
+		}
+	}
+
+	Mtx_Multiply(&stk->mvp, &stk->projView, model);
+	upload |= BIT(C3D_MVP_MVP);
+
+	for (i = 0; i < C3D_MVP_COUNT; i ++)
+	{
+		if (!(upload & BIT(i)) || stk->unifPos[i] == 0xFF) continue;
+		const C3D_Mtx* mtx = i == C3D_MVP_PROJECTION ? &stk->proj :
+		                     i == C3D_MVP_MODELVIEW  ? &stk->modelView :
+		                     i == C3D_MVP_MVP        ? &stk->mvp : &stk->normal;
+		C3D_FVUnifMtxNx4(stk->unifType[i], stk->unifPos[i], mtx, stk->unifLen[i]);
+	}
+
+	stk->dirty = 0;
+}
@@ -0,0 +1,259 @@
+#include "internal.h"
+#include <c3d/base.h>
+#include <c3d/rendergraph.h>
+
+#define SLOT_ALIGN 0x80
+
+static inline u32 alignSlot(u32 size)
+{
+	return (size + SLOT_ALIGN - 1) &~ (SLOT_ALIGN - 1);
+}
+
+static void C3Di_RenderGraphRelease(C3D_RenderGraph* rg)
+{
+	int i;
+	if (!rg->numSlotMem) return;
+
+	C3Di_RenderQueueWaitDone();
+	for (i = 0; i < rg->numSlotMem; i ++)
+		vramFree(rg->slotMem[i]);
+	rg->numSlotMem = 0;
+}
+
+void C3D_RenderGraphInit(C3D_RenderGraph* rg)
+{
+	memset(rg, 0, sizeof(*rg));
+}
+
+void C3D_RenderGraphFree(C3D_RenderGraph* rg)
+{
+	C3Di_RenderGraphRelease(rg);
+	C3D_RenderGraphInit(rg);
+}
+
+static int C3Di_RenderGraphNewRes(C3D_RenderGraph* rg)
+{
+	if (rg->numRes >= C3D_RENDERGRAPH_MAX_RESOURCES)
+		return -1;
+
+	int id = rg->numRes++;
+	C3D_RenderGraphRes* r = &rg->res[id];
+	memset(r, 0, sizeof(*r));
+	r->depthFmt = -1;
+	rg->compiled = false;
+	return id;
+}
+
+int C3D_RenderGraphImport(C3D_RenderGraph* rg, C3D_RenderTarget* target)
+{
+	int id = C3Di_RenderGraphNewRes(rg);
+	if (id >= 0)
+		rg->res[id].target = target;
+	return id;
+}
+
+int C3D_RenderGraphTransient(C3D_RenderGraph* rg, C3D_TexInitParams p, C3D_DEPTHTYPE depthFmt)
+{
+	// Only single-level textures in a color buffer format can be rendered to
+	if (p.format > GPU_RGBA4 || (p.type != GPU_TEX_2D && p.type != GPU_TEX_SHADOW_2D))
+		return -1;
+
+	int id = C3Di_RenderGraphNewRes(rg);
+	if (id < 0) return -1;
+
+	C3D_RenderGraphRes* r = &rg->res[id];
+	p.maxLevel = 0;
+	p.onVram = true;
+	r->texParams = p;
+	r->transient = true;
+	if (C3D_DEPTHTYPE_OK(depthFmt))
+		r->depthFmt = C3D_DEPTHTYPE_VAL(depthFmt);
+	return id;
+}
+
+void C3D_RenderGraphSetClear(C3D_RenderGraph* rg, int res, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth)
+{
+	if (res < 0 || res >= rg->numRes) return;
+
+	C3D_RenderGraphRes* r = &rg->res[res];
+	r->clearBits = clearBits;
+	r->clearColor = clearColor;
+	r->clearDepth = clearDepth;
+	rg->compiled = false;
+}
+
+C3D_Tex* C3D_RenderGraphTex(C3D_RenderGraph* rg, int res)
+{
+	if (res < 0 || res >= rg->numRes || !rg->res[res].transient)
+		return NULL;
+	return &rg->res[res].tex;
+}
+
+C3D_RenderTarget* C3D_RenderGraphTarget(C3D_RenderGraph* rg, int res)
+{
+	if (res < 0 || res >= rg->numRes)
+		return NULL;
+	return rg->res[res].target;
+}
+
+int C3D_RenderGraphAddPass(C3D_RenderGraph* rg, int target, C3D_RenderPassFunc func, void* user)
+{
+	if (rg->numPasses >= C3D_RENDERGRAPH_MAX_PASSES || target < 0 || target >= rg->numRes)
+		return -1;
+
+	int id = rg->numPasses++;
+	C3D_RenderPass* p = &rg->pass[id];
+	p->func = func;
+	p->user = user;
+	p->reads = 0;
+	p->target = target;
+	rg->compiled = false;
+	return id;
+}
+
+void C3D_RenderGraphPassReads(C3D_RenderGraph* rg, int pass, int res)
+{
+	if (pass < 0 || pass >= rg->numPasses || res < 0 || res >= rg->numRes)
+		return;
+	rg->pass[pass].reads |= BIT(res);
+	rg->compiled = false;
+}
+
+static u32 C3Di_RenderGraphResSize(C3D_RenderGraphRes* r, u32* depthOffset)
+{
+	C3D_TexInitParams p = r->texParams;
+	u32 size = alignSlot(C3Di_TexInitPlaced(&r->tex, NULL, p));
+	*depthOffset = size;
+	if (r->depthFmt >= 0)
+		size += alignSlot(C3D_CalcDepthBufSize(p.width, p.height, (GPU_DEPTHBUF)r->depthFmt));
+	return size;
+}
+
+// Depth buffer group of an imported target, the first imported resource that
+// draws with the same depth buffer
+static s8 C3Di_RenderGraphDepthGroup(C3D_RenderGraph* rg, int id)
+{
+	int i;
+	C3D_FrameBuf* fb = &rg->res[id].target->frameBuf;
+	if (!fb->depthBuf)
+		return -1;
+	for (i = 0; i < id; i ++)
+	{
+		C3D_RenderGraphRes* r = &rg->res[i];
+		C3D_FrameBuf* other = &r->target->frameBuf;
+		if (!r->transient && other->depthBuf == fb->depthBuf && other->depthFmt == fb->depthFmt
+			&& other->width == fb->width && other->height == fb->height)
+			return i;
+	}
+	return id;
+}
+
+bool C3D_RenderGraphCompile(C3D_RenderGraph* rg)
+{
+	int i, s;
+	C3D_RenderPlan* plan = &rg->plan;
+	C3D_RenderPlanPass passes[C3D_RENDERGRAPH_MAX_PASSES];
+	C3D_RenderPlanRes res[C3D_RENDERGRAPH_MAX_RESOURCES];
+	u32 depthOffset[C3D_RENDERGRAPH_MAX_RESOURCES];
+
+	C3Di_RenderGraphRelease(rg);
+	rg->compiled = false;
+
+	for (i = 0; i < rg->numPasses; i ++)
+	{
+		passes[i].reads = rg->pass[i].reads;
+		passes[i].target = rg->pass[i].target;
+	}
+	for (i = 0; i < rg->numRes; i ++)
+	{
+		C3D_RenderGraphRes* r = &rg->res[i];
+		res[i].clearBits = r->clearBits;
+		res[i].size = r->transient ? C3Di_RenderGraphResSize(r, &depthOffset[i]) : 0;
+		res[i].depthGroup = r->transient ? -1 : C3Di_RenderGraphDepthGroup(rg, i);
+	}
+	RenderPlan_Build(plan, passes, rg->numPasses, res, rg->numRes);
+
+	for (s = 0; s < plan->numSlots; s ++)
+	{
+		rg->slotMem[s] = vramAlloc(plan->slotSize[s]);
+		if (!rg->slotMem[s])
+		{
+			C3Di_RenderGraphRelease(rg);
+			return false;
+		}
+		rg->numSlotMem ++;
+	}
+
+	for (i = 0; i < rg->numRes; i ++)
+	{
+		C3D_RenderGraphRes* r = &rg->res[i];
+		if (plan->slot[i] < 0)
+			continue;
+
+		u8* mem = (u8*)rg->slotMem[plan->slot[i]];
+		C3D_FrameBuf* fb = &r->own.frameBuf;
+		memset(&r->own, 0, sizeof(r->own));
+		C3Di_TexInitPlaced(&r->tex, mem, r->texParams);
+		C3D_FrameBufTex(fb, &r->tex, GPU_TEXFACE_2D, 0);
+		if (r->depthFmt >= 0)
+			C3D_FrameBufDepth(fb, mem + depthOffset[i], (GPU_DEPTHBUF)r->depthFmt);
+		r->target = &r->own;
+	}
+
+	rg->compiled = true;
+	return true;
+}
+
+static int C3Di_RenderGraphFills(C3D_RenderGraph* rg, u16 mask, C3Di_MemFill* fills)
+{
+	int i, n = 0;
+	for (i = 0; i < rg->numRes; i ++)
+	{
+		C3D_RenderGraphRes* r = &rg->res[i];
+		if (mask & BIT(i))
+			n += C3Di_FrameBufFills(&r->target->frameBuf, r->clearBits, r->clearColor, r->clearDepth, &fills[n]);
+	}
+	return n;
+}
+
+bool C3D_RenderGraphExecute(C3D_RenderGraph* rg)
+{
+	int k;
+	C3D_Context* ctx = C3Di_GetContext();
+	C3D_RenderPlan* plan = &rg->plan;
+	C3Di_MemFill fills[2*C3D_RENDERGRAPH_MAX_RESOURCES];
+
+	if (!rg->compiled || !(ctx->flags & C3DiF_Active))
+		return false;
+
+	// Clears of all resources that do not reuse VRAM are merged up front
+	if (plan->clearEarly && !C3Di_FrameMemFill(fills, C3Di_RenderGraphFills(rg, plan->clearEarly, fills)))
+		return false;
+
+	for (k = 0; k < plan->numScheduled; k ++)
+	{
+		C3D_RenderPass* p = &rg->pass[plan->order[k]];
+		C3D_RenderTarget* target = rg->res[p->target].target;
+
+		if (plan->clearAt[k] && !C3Di_FrameMemFill(fills, C3Di_RenderGraphFills(rg, plan->clearAt[k], fills)))
+			return false;
+
+		if (k > 0 && rg->pass[plan->order[k-1]].target == p->target)
+			C3D_SetViewport(0, 0, target->frameBuf.width, target->frameBuf.height);
+		else
+		{
+			// The previous target still has to be flushed since binding the next one
+			// invalidates the framebuffer cache, but the early depth buffer stays valid
+			if ((plan->keepEarlyDepth & BIT(k)) && (ctx->flags & C3DiF_DrawUsed))
+			{
+				ctx->flags &= ~C3DiF_DrawUsed;
+				GPUCMD_AddWrite(GPUREG_FRAMEBUFFER_FLUSH, 1);
+			}
+			if (!C3D_FrameDrawOn(target))
+				return false;
+		}
+
+		p->func(p->user);
+	}
+	return true;
+}
@@ -0,0 +1,166 @@
+#include <c3d/renderplan.h>
+#include <string.h>
+
+// Orders the passes that contribute to an imported target, keeping passes that
+// draw on the same target next to each other whenever dependencies allow it
+static void schedule(C3D_RenderPlan* plan, const C3D_RenderPlanPass* passes, int numPasses, const C3D_RenderPlanRes* res, int numRes)
+{
+	int i, j;
+	u16 live = 0, needed = 0, done = 0;
+	u16 deps[C3D_RENDERGRAPH_MAX_PASSES];
+
+	for (i = 0; i < numRes; i ++)
+		if (!res[i].size)
+			needed |= BIT(i);
+
+	for (i = numPasses-1; i >= 0; i --)
+	{
+		const C3D_RenderPlanPass* p = &passes[i];
+		if (!(needed & BIT(p->target)))
+			continue;
+		live |= BIT(i);
+		needed |= p->reads;
+	}
+
+	for (j = 0; j < numPasses; j ++)
+	{
+		const C3D_RenderPlanPass* b = &passes[j];
+		deps[j] = 0;
+		for (i = 0; i < j; i ++)
+		{
+			const C3D_RenderPlanPass* a = &passes[i];
+			if ((live & BIT(i)) && (a->target == b->target || (b->reads & BIT(a->target)) || (a->reads & BIT(b->target))))
+				deps[j] |= BIT(i);
+		}
+	}
+
+	int lastTarget = -1;
+	while (done != live)
+	{
+		int pick = -1;
+		for (j = 0; j < numPasses; j ++)
+		{
+			if (!(live & BIT(j)) || (done & BIT(j)) || (deps[j] &~ done))
+				continue;
+			if (pick < 0)
+				pick = j;
+			if (passes[j].target == lastTarget)
+			{
+				pick = j;
+				break;
+			}
+		}
+		done |= BIT(pick);
+		lastTarget = passes[pick].target;
+		plan->order[plan->numScheduled++] = pick;
+	}
+}
+
+static void lifetimes(C3D_RenderPlan* plan, const C3D_RenderPlanPass* passes, int numRes)
+{
+	int i, k;
+	for (k = 0; k < plan->numScheduled; k ++)
+	{
+		const C3D_RenderPlanPass* p = &passes[plan->order[k]];
+		u16 used = p->reads | BIT(p->target);
+		for (i = 0; i < numRes; i ++)
+		{
+			if (!(used & BIT(i))) continue;
+			if (plan->first[i] < 0)
+				plan->first[i] = k;
+			plan->last[i] = k;
+		}
+	}
+}
+
+// Transient resources whose lifetimes do not overlap share the same VRAM block.
+// Only the first user of a block is cleared when the graph starts; later users
+// are cleared right before their first pass, once the previous user is done.
+static void alias(C3D_RenderPlan* plan, const C3D_RenderPlanRes* res, int numRes)
+{
+	int i, j, s;
+	s8 slotLast[C3D_RENDERGRAPH_MAX_RESOURCES];
+	u8 sorted[C3D_RENDERGRAPH_MAX_RESOURCES];
+	int numSorted = 0;
+
+	for (i = 0; i < numRes; i ++)
+	{
+		if (!res[i].size || plan->first[i] < 0)
+			continue;
+		for (j = numSorted; j > 0 && plan->first[sorted[j-1]] > plan->first[i]; j --)
+			sorted[j] = sorted[j-1];
+		sorted[j] = i;
+		numSorted ++;
+	}
+
+	for (j = 0; j < numSorted; j ++)
+	{
+		i = sorted[j];
+		u32 need = res[i].size;
+		int best = -1;
+		for (s = 0; s < plan->numSlots; s ++)
+		{
+			if (slotLast[s] >= plan->first[i])
+				continue;
+			if (best < 0)
+				best = s;
+			else if (plan->slotSize[s] >= need)
+			{
+				if (plan->slotSize[best] < need || plan->slotSize[s] < plan->slotSize[best])
+					best = s;
+			} else if (plan->slotSize[best] < plan->slotSize[s])
+				best = s;
+		}
+
+		if (best < 0)
+		{
+			best = plan->numSlots++;
+			plan->slotSize[best] = 0;
+			if (res[i].clearBits)
+				plan->clearEarly |= BIT(i);
+		} else if (res[i].clearBits)
+			plan->clearAt[plan->first[i]] |= BIT(i);
+
+		if (plan->slotSize[best] < need)
+			plan->slotSize[best] = need;
+		slotLast[best] = plan->last[i];
+		plan->slot[i] = best;
+	}
+}
+
+// Switching between targets that draw with the same depth buffer leaves the
+// early depth buffer valid. Memory fills split the command list, which clears
+// it anyway, and clears of imported targets all happen before the first pass.
+static void earlyDepth(C3D_RenderPlan* plan, const C3D_RenderPlanPass* passes, const C3D_RenderPlanRes* res)
+{
+	int k;
+	for (k = 1; k < plan->numScheduled; k ++)
+	{
+		const C3D_RenderPlanPass* a = &passes[plan->order[k-1]];
+		const C3D_RenderPlanPass* b = &passes[plan->order[k]];
+		s8 group = res[b->target].depthGroup;
+		if (a->target == b->target || group < 0 || res[a->target].depthGroup != group)
+			continue;
+		if (!(b->reads & BIT(a->target)) && !plan->clearAt[k])
+			plan->keepEarlyDepth |= BIT(k);
+	}
+}
+
+void RenderPlan_Build(C3D_RenderPlan* plan, const C3D_RenderPlanPass* passes, int numPasses, const C3D_RenderPlanRes* res, int numRes)
+{
+	int i;
+	memset(plan, 0, sizeof(*plan));
+	memset(plan->first, -1, sizeof(plan->first));
+	memset(plan->last, -1, sizeof(plan->last));
+	memset(plan->slot, -1, sizeof(plan->slot));
+
+	schedule(plan, passes, numPasses, res, numRes);
+	lifetimes(plan, passes, numRes);
+	alias(plan, res, numRes);
+
+	for (i = 0; i < numRes; i ++)
+		if (!res[i].size && plan->first[i] >= 0 && res[i].clearBits)
+			plan->clearEarly |= BIT(i);
+
+	earlyDepth(plan, passes, res);
+}
@@ -6,7 +6,7 @@
 static C3D_RenderTarget *firstTarget, *lastTarget;
 static C3D_RenderTarget *linkedTarget[3];
 
-static TickCounter gpuTime, cpuTime;
+static TickCounter gpuTime, cpuTime, waitTime;
 
 #define STAGE_HAS_TRANSFER(n)   BIT(0+(n))
 #define STAGE_HAS_ANY_TRANSFER  (7<<0)
@@ -15,12 +15,33 @@ static TickCounter gpuTime, cpuTime;
 #define STAGE_NEED_BOT_TRANSFER STAGE_NEED_TRANSFER(2)
 #define STAGE_WAIT_TRANSFER     BIT(6)
 
+#define MAX_DEFERRED 16
+
 static bool initialized;
-static bool inFrame, inSafeTransfer, measureGpuTime;
+static bool inFrame, inSafeTransfer, measureGpuTime, dynResPending;
+static bool queueAcquired;
 static u8 frameStage;
+static int frameLatency = 1;
+static u32* spareCmdBuf;
+static int numDeferred;
+static struct
+{
+	u32* buf; // NULL for a memory fill
+	u32 size;
+	u8 flags;
+	u8 numFills;
+	C3Di_MemFill fills[2];
+} deferred[MAX_DEFERRED];
 static float framerate = 60.0f;
 static float framerateCounter[2] = { 60.0f, 60.0f };
 static u32 frameCounter[2];
+static u32 frameIndex;
+
+static C3D_FrameStats *statsRing, statsCur, statsSubmitted;
+static float* statsScratch;
+static int statsCapacity, statsHead, statsCount;
+static bool statsPending;
+static u32 statsLastBegin;
 
 static bool framerateLimit(int id)
 {
@@ -33,6 +54,22 @@ static bool framerateLimit(int id)
 	return false;
 }
 
+// Gathers the fills needed to clear a target, issuing them in pairs so that
+// both units of a GX_MemoryFill command are used. The batch holds 3 fills.
+static void C3Di_ClearBatchAdd(C3Di_MemFill* batch, int* count, C3D_RenderTarget* target, C3D_ClearBits skip)
+{
+	int n = *count + C3Di_FrameBufFills(&target->frameBuf, target->clearBits &~ skip,
+		target->clearColor, target->clearDepth, &batch[*count]);
+	if (n >= 2)
+	{
+		C3Di_MemFillSubmit(batch, n &~ 1);
+		if (n & 1)
+			batch[0] = batch[n-1];
+		n &= 1;
+	}
+	*count = n;
+}
+
 static void onVBlank0(C3D_UNUSED void* unused)
 {
 	if (frameStage & STAGE_NEED_TOP_TRANSFER)
@@ -48,15 +85,18 @@ static void onVBlank0(C3D_UNUSED void* unused)
 		frameStage &= ~STAGE_NEED_TOP_TRANSFER;
 		if (left || right)
 		{
+			C3Di_MemFill fills[3];
+			int numFills = 0;
 			frameStage |= STAGE_WAIT_TRANSFER;
 			if (left)
-				C3D_FrameBufTransfer(&left->frameBuf, GFX_TOP, GFX_LEFT, left->transferFlags);
+				C3Di_FrameBufTransfer(&left->frameBuf, GFX_TOP, GFX_LEFT, left->transferFlags);
 			if (right)
-				C3D_FrameBufTransfer(&right->frameBuf, GFX_TOP, GFX_RIGHT, right->transferFlags);
-			if (left && left->clearBits)
-				C3D_FrameBufClear(&left->frameBuf, left->clearBits, left->clearColor, left->clearDepth);
-			if (right && right != left && right->clearBits)
-				C3D_FrameBufClear(&right->frameBuf, right->clearBits, right->clearColor, right->clearDepth);
+				C3Di_FrameBufTransfer(&right->frameBuf, GFX_TOP, GFX_RIGHT, right->transferFlags);
+			if (left)
+				C3Di_ClearBatchAdd(fills, &numFills, left, left->clearSkip);
+			if (right && right != left)
+				C3Di_ClearBatchAdd(fills, &numFills, right, right->clearSkip);
+			C3Di_MemFillSubmit(fills, numFills);
 			gfxConfigScreen(GFX_TOP, false);
 		}
 	}
@@ -72,10 +112,12 @@ static void onVBlank1(C3D_UNUSED void* unused)
 		C3D_RenderTarget* target = linkedTarget[2];
 		if (target)
 		{
+			C3Di_MemFill fills[3];
+			int numFills = 0;
 			frameStage |= STAGE_WAIT_TRANSFER;
-			C3D_FrameBufTransfer(&target->frameBuf, GFX_BOTTOM, GFX_LEFT, target->transferFlags);
-			if (target->clearBits)
-				C3D_FrameBufClear(&target->frameBuf, target->clearBits, target->clearColor, target->clearDepth);
+			C3Di_FrameBufTransfer(&target->frameBuf, GFX_BOTTOM, GFX_LEFT, target->transferFlags);
+			C3Di_ClearBatchAdd(fills, &numFills, target, target->clearSkip);
+			C3Di_MemFillSubmit(fills, numFills);
 			gfxConfigScreen(GFX_BOTTOM, false);
 		}
 	}
@@ -83,6 +125,20 @@ static void onVBlank1(C3D_UNUSED void* unused)
 		frameCounter[1]++;
 }
 
+// Called on the main thread after waiting for the GPU, onQueueFinish only
+// latches the GPU time since the stats are read without any locking
+static void C3Di_FrameStatsCommit(void)
+{
+	if (!statsPending || measureGpuTime)
+		return;
+	statsSubmitted.gpuTime = osTickCounterRead(&gpuTime);
+	statsRing[statsHead] = statsSubmitted;
+	statsHead = (statsHead + 1) % statsCapacity;
+	if (statsCount < statsCapacity)
+		statsCount ++;
+	statsPending = false;
+}
+
 static void onQueueFinish(gxCmdQueue_s* queue)
 {
 	if (measureGpuTime)
@@ -120,6 +176,11 @@ void C3D_FrameSync(void)
 	} while (cur[0]==start[0] || cur[1]==start[1]);
 }
 
+u32 C3Di_FrameIndex(void)
+{
+	return frameIndex;
+}
+
 u32 C3D_FrameCounter(int id)
 {
 	return frameCounter[id];
@@ -139,6 +200,36 @@ static bool C3Di_WaitAndClearQueue(s64 timeout)
 	return true;
 }
 
+// Waits for the previous frame to be completely done and takes over the
+// command queue, submitting any work that was deferred meanwhile.
+static void C3Di_AcquireQueue(void)
+{
+	int i;
+	if (queueAcquired) return;
+
+	osTickCounterStart(&waitTime);
+	C3Di_WaitAndClearQueue(-1);
+	osTickCounterUpdate(&waitTime);
+	statsCur.waitTime += osTickCounterRead(&waitTime);
+	C3Di_FrameStatsCommit();
+
+	for (i = 0; i < numDeferred; i ++)
+	{
+		if (deferred[i].buf)
+			GX_ProcessCommandList(deferred[i].buf, deferred[i].size*4, deferred[i].flags);
+		else
+			C3Di_MemFillSubmit(deferred[i].fills, deferred[i].numFills);
+	}
+	numDeferred = 0;
+	queueAcquired = true;
+}
+
+void C3D_FrameFlushDeferred(void)
+{
+	if (inFrame)
+		C3Di_AcquireQueue();
+}
+
 static void C3Di_RenderQueueInit(void)
 {
 	gspSetEventCallback(GSPGPU_EVENT_VBlank0, onVBlank0, NULL, false);
@@ -153,6 +244,8 @@ void C3Di_RenderQueueExit(void)
 	int i;
 	C3D_RenderTarget *a, *next;
 
+	C3D_FrameStatsEnable(0);
+	C3D_FrameLatency(1);
 	if (!initialized)
 		return;
 
@@ -208,15 +301,83 @@ float C3D_FrameRate(float fps)
 	return old;
 }
 
+static void C3Di_RenderTargetApplyDynRes(C3D_RenderTarget* target, int level)
+{
+	// Each level halves the pixel count by dropping one step of the supersampling
+	// that the display transfer would otherwise downscale to the screen resolution.
+	u32 width = target->fullWidth, height = target->fullHeight;
+	u32 scaling = target->fullScaling;
+	if (level > 0 && scaling == GX_TRANSFER_SCALE_XY)
+	{
+		height /= 2;
+		scaling = GX_TRANSFER_SCALE_X;
+		level --;
+	}
+	if (level > 0 && scaling == GX_TRANSFER_SCALE_X)
+	{
+		width /= 2;
+		scaling = GX_TRANSFER_SCALE_NO;
+	}
+
+	C3D_FrameBuf* fb = &target->frameBuf;
+	if (fb->width == width && fb->height == height)
+		return;
+
+	C3D_FrameBufAttrib(fb, width, height, fb->block32);
+	target->transferFlags = (target->transferFlags &~ GX_TRANSFER_SCALING(3)) | GX_TRANSFER_SCALING(scaling);
+	if (target->clearBits)
+		C3D_FrameBufClear(fb, target->clearBits, target->clearColor, target->clearDepth);
+}
+
+static void C3Di_RenderTargetDynResUpdate(C3D_RenderTarget* target, float gpuTime)
+{
+	C3Di_RenderTargetApplyDynRes(target, DynRes_Update(target->dynRes, gpuTime));
+}
+
 bool C3D_FrameBegin(u8 flags)
 {
 	if (inFrame) return false;
+	osTickCounterStart(&waitTime);
 	if (flags & C3D_FRAME_SYNCDRAW)
 		C3D_FrameSync();
-	if (!C3Di_WaitAndClearQueue((flags & C3D_FRAME_NONBLOCK) ? 0 : -1))
-		return false;
+	if (frameLatency > 1 && !(flags & C3D_FRAME_NONBLOCK))
+	{
+		// The previous frame may still be in flight: its command lists were recorded
+		// into the other command buffer, so this frame only needs to wait for it once
+		// its own command lists are about to be submitted. A non-blocking begin
+		// can't promise that wait won't block later, so it fails like with latency 1.
+		queueAcquired = false;
+	} else
+	{
+		if (!C3Di_WaitAndClearQueue((flags & C3D_FRAME_NONBLOCK) ? 0 : -1))
+			return false;
+		queueAcquired = true;
+		C3Di_FrameStatsCommit();
+	}
+	osTickCounterUpdate(&waitTime);
 	inFrame = true;
+	frameIndex ++;
 	osTickCounterStart(&cpuTime);
+
+	// Render targets may only be resized while none of them are in use by the GPU
+	if (dynResPending && !frameStage && gxCmdQueueWait(&C3Di_GetContext()->gxQueue, 0))
+	{
+		C3D_RenderTarget* target;
+		float time = osTickCounterRead(&gpuTime);
+		dynResPending = false;
+		for (target = firstTarget; target; target = target->next)
+			if (target->dynRes)
+				C3Di_RenderTargetDynResUpdate(target, time);
+	}
+
+	if (statsRing)
+	{
+		u32 elapsed = frameCounter[0] - statsLastBegin;
+		statsLastBegin = frameCounter[0];
+		memset(&statsCur, 0, sizeof(statsCur));
+		statsCur.waitTime = osTickCounterRead(&waitTime);
+		statsCur.vblankMisses = elapsed > 1 ? (elapsed < 0x10000 ? elapsed-1 : 0xFFFF) : 0;
+	}
 	return true;
 }
 
@@ -235,7 +396,44 @@ void C3D_FrameSplit(u8 flags)
 	u32 *cmdBuf, cmdBufSize;
 	if (!inFrame) return;
 	if (C3Di_SplitFrame(&cmdBuf, &cmdBufSize))
-		GX_ProcessCommandList(cmdBuf, cmdBufSize*4, flags);
+	{
+		statsCur.splits ++;
+		statsCur.cmdWords = cmdBuf + cmdBufSize - C3Di_GetContext()->cmdBuf;
+		if (!queueAcquired && numDeferred == MAX_DEFERRED)
+			C3Di_AcquireQueue();
+		if (queueAcquired)
+			GX_ProcessCommandList(cmdBuf, cmdBufSize*4, flags);
+		else
+		{
+			deferred[numDeferred].buf = cmdBuf;
+			deferred[numDeferred].size = cmdBufSize;
+			deferred[numDeferred].flags = flags;
+			numDeferred ++;
+		}
+	}
+}
+
+// Queues memory fills in order with the commands recorded so far this frame
+bool C3Di_FrameMemFill(const C3Di_MemFill* fills, int count)
+{
+	if (!inFrame) return false;
+	C3D_FrameSplit(0);
+	for (; count > 0; count -= 2, fills += 2)
+	{
+		int n = count > 2 ? 2 : count;
+		if (!queueAcquired && numDeferred == MAX_DEFERRED)
+			C3Di_AcquireQueue();
+		if (queueAcquired)
+			C3Di_MemFillSubmit(fills, n);
+		else
+		{
+			deferred[numDeferred].buf = NULL;
+			deferred[numDeferred].numFills = n;
+			memcpy(deferred[numDeferred].fills, fills, n*sizeof(C3Di_MemFill));
+			numDeferred ++;
+		}
+	}
+	return true;
 }
 
 void C3D_FrameEnd(u8 flags)
@@ -254,6 +452,8 @@ void C3D_FrameEnd(u8 flags)
 		GSPGPU_FlushDataCache((void*)__ctru_linear_heap, __ctru_linear_heap_size);
 	}
 
+	C3Di_AcquireQueue();
+
 	int i;
 	C3D_RenderTarget* target;
 	for (i = 2; i >= 0; i --)
@@ -262,23 +462,72 @@ void C3D_FrameEnd(u8 flags)
 		if (!target || !target->used)
 			continue;
 		target->used = false;
+		target->clearSkip = target->overwritten;
+		target->overwritten = 0;
 		frameStage |= STAGE_HAS_TRANSFER(i);
 	}
 
+	C3Di_MemFill fills[3];
+	int numFills = 0;
 	for (target = firstTarget; target; target = target->next)
 	{
-		if (!target->used || !target->clearBits)
+		if (!target->used)
 			continue;
 		target->used = false;
-		C3D_FrameBufClear(&target->frameBuf, target->clearBits, target->clearColor, target->clearDepth);
+		C3Di_ClearBatchAdd(fills, &numFills, target, target->overwritten);
+		target->overwritten = 0;
+	}
+	C3Di_MemFillSubmit(fills, numFills);
+
+	if (statsRing)
+	{
+		statsCur.cpuTime = osTickCounterRead(&cpuTime);
+		statsSubmitted = statsCur;
+		statsPending = true;
+	}
+
+	// Record the next frame into the other command buffer while this one executes
+	if (frameLatency > 1)
+	{
+		u32* buf = ctx->cmdBuf;
+		ctx->cmdBuf = spareCmdBuf;
+		spareCmdBuf = buf;
 	}
 
 	GPUCMD_SetBuffer(ctx->cmdBuf, ctx->cmdBufSize, 0);
 	measureGpuTime = true;
+	dynResPending = true;
 	osTickCounterStart(&gpuTime);
 	gxCmdQueueRun(&ctx->gxQueue);
 }
 
+int C3D_FrameLatency(int n)
+{
+	C3D_Context* ctx = C3Di_GetContext();
+	int old = frameLatency;
+	if (n < 1 || n > C3D_MAX_FRAME_LATENCY || n == old || inFrame)
+		return old;
+
+	if (initialized)
+		C3Di_WaitAndClearQueue(-1);
+
+	if (n > 1)
+	{
+		if (!(ctx->flags & C3DiF_Active))
+			return old;
+		spareCmdBuf = (u32*)linearAlloc(ctx->cmdBufSize*4);
+		if (!spareCmdBuf)
+			return old;
+	} else
+	{
+		linearFree(spareCmdBuf);
+		spareCmdBuf = NULL;
+	}
+
+	frameLatency = n;
+	return old;
+}
+
 float C3D_GetDrawingTime(void)
 {
 	return osTickCounterRead(&gpuTime);
@@ -289,6 +538,100 @@ float C3D_GetProcessingTime(void)
 	return osTickCounterRead(&cpuTime);
 }
 
+bool C3D_FrameStatsEnable(int capacity)
+{
+	if (inFrame) return false;
+	if (initialized)
+		C3Di_WaitAndClearQueue(-1);
+
+	free(statsRing);
+	free(statsScratch);
+	statsRing = NULL;
+	statsScratch = NULL;
+	statsCapacity = statsHead = statsCount = 0;
+	statsPending = false;
+	if (capacity <= 0)
+		return true;
+
+	statsRing = (C3D_FrameStats*)malloc(capacity*sizeof(C3D_FrameStats));
+	statsScratch = (float*)malloc(capacity*sizeof(float));
+	if (!statsRing || !statsScratch)
+	{
+		free(statsRing);
+		free(statsScratch);
+		statsRing = NULL;
+		statsScratch = NULL;
+		return false;
+	}
+
+	statsCapacity = capacity;
+	statsLastBegin = frameCounter[0];
+	return true;
+}
+
+int C3D_FrameStatsCount(void)
+{
+	return statsCount;
+}
+
+static const C3D_FrameStats* C3Di_FrameStatsAt(int age)
+{
+	return &statsRing[(statsHead + statsCapacity - 1 - age) % statsCapacity];
+}
+
+bool C3D_FrameStatsGet(int age, C3D_FrameStats* out)
+{
+	if (age < 0 || age >= statsCount) return false;
+	*out = *C3Di_FrameStatsAt(age);
+	return true;
+}
+
+static float C3Di_FrameStatsField(const C3D_FrameStats* st, C3D_FrameStatsField field)
+{
+	switch (field)
+	{
+		case C3D_FRAMESTAT_CPU_TIME:      return st->cpuTime;
+		case C3D_FRAMESTAT_GPU_TIME:      return st->gpuTime;
+		case C3D_FRAMESTAT_WAIT_TIME:     return st->waitTime;
+		case C3D_FRAMESTAT_CMD_WORDS:     return st->cmdWords;
+		case C3D_FRAMESTAT_SPLITS:        return st->splits;
+		case C3D_FRAMESTAT_VBLANK_MISSES: return st->vblankMisses;
+		default:                          return 0.0f;
+	}
+}
+
+static int C3Di_FloatCompare(const void* a, const void* b)
+{
+	float x = *(const float*)a, y = *(const float*)b;
+	return (x > y) - (x < y);
+}
+
+bool C3D_FrameStatsQuery(C3D_FrameStatsField field, int window, C3D_FrameStatsSummary* out)
+{
+	int i;
+	if (window <= 0 || window > statsCount)
+		window = statsCount;
+	if (!window) return false;
+
+	float sum = 0.0f;
+	for (i = 0; i < window; i ++)
+	{
+		float val = C3Di_FrameStatsField(C3Di_FrameStatsAt(i), field);
+		statsScratch[i] = val;
+		sum += val;
+	}
+	qsort(statsScratch, window, sizeof(float), C3Di_FloatCompare);
+
+	// Nearest-rank percentiles
+	out->count = window;
+	out->min = statsScratch[0];
+	out->max = statsScratch[window-1];
+	out->avg = sum / window;
+	out->p95 = statsScratch[(window*95 + 99)/100 - 1];
+	out->p99 = statsScratch[(window*99 + 99)/100 - 1];
+	return true;
+}
+
 static C3D_RenderTarget* C3Di_RenderTargetNew(void)
 {
 	C3D_RenderTarget* target = (C3D_RenderTarget*)malloc(sizeof(C3D_RenderTarget));
@@ -410,11 +753,21 @@ void C3D_RenderTargetSetClear(C3D_RenderTarget* target, C3D_ClearBits clearBits,
 		C3D_FrameBufClear(&target->frameBuf, clearBits, clearColor, clearDepth);
 }
 
+void C3D_RenderTargetMarkOverwritten(C3D_RenderTarget* target, C3D_ClearBits bits)
+{
+	target->overwritten |= bits;
+}
+
 void C3D_RenderTargetSetOutput(C3D_RenderTarget* target, gfxScreen_t screen, gfx3dSide_t side, u32 transferFlags)
 {
 	int id = 0;
 	if (screen==GFX_BOTTOM) id = 2;
 	else if (side==GFX_RIGHT) id = 1;
+
+	C3D_DynRes* dr = target->dynRes;
+	if (dr)
+		C3D_RenderTargetSetDynRes(target, NULL);
+
 	if (linkedTarget[id])
 		linkedTarget[id]->linked = false;
 	linkedTarget[id] = target;
@@ -422,10 +775,47 @@ void C3D_RenderTargetSetOutput(C3D_RenderTarget* target, gfxScreen_t screen, gfx
 	target->transferFlags = transferFlags;
 	target->screen = screen;
 	target->side = side;
+
+	if (dr)
+		C3D_RenderTargetSetDynRes(target, dr);
+}
+
+void C3D_RenderTargetSetDynRes(C3D_RenderTarget* target, C3D_DynRes* dr)
+{
+	static const float levelCost[] = { 1.0f, 0.5f, 0.25f };
+
+	if (inFrame)
+		svcBreak(USERBREAK_PANIC); // Shouldn't happen.
+	C3Di_WaitAndClearQueue(-1);
+
+	// Go back to the full allocated size before (re)configuring
+	if (target->dynRes)
+	{
+		C3Di_RenderTargetApplyDynRes(target, 0);
+		target->dynRes = NULL;
+	}
+	if (!dr) return;
+
+	target->fullWidth = target->frameBuf.width;
+	target->fullHeight = target->frameBuf.height;
+	target->fullScaling = (target->transferFlags >> 24) & 3;
+	target->dynRes = dr;
+
+	int numLevels = 1;
+	if (target->linked)
+	{
+		if (target->fullScaling == GX_TRANSFER_SCALE_XY)
+			numLevels = 3;
+		else if (target->fullScaling == GX_TRANSFER_SCALE_X)
+			numLevels = 2;
+	}
+	DynRes_SetLevels(dr, levelCost, numLevels);
+	C3Di_RenderTargetApplyDynRes(target, dr->level);
 }
 
 void C3D_SafeDisplayTransfer(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 flags)
 {
+	C3D_FrameFlushDeferred();
 	C3Di_WaitAndClearQueue(-1);
 	inSafeTransfer = true;
 	GX_DisplayTransfer(inadr, indim, outadr, outdim, flags);
@@ -434,6 +824,7 @@ void C3D_SafeDisplayTransfer(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32
 
 void C3D_SafeTextureCopy(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 size, u32 flags)
 {
+	C3D_FrameFlushDeferred();
 	C3Di_WaitAndClearQueue(-1);
 	inSafeTransfer = true;
 	GX_TextureCopy(inadr, indim, outadr, outdim, size, flags);
@@ -442,6 +833,7 @@ void C3D_SafeTextureCopy(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 siz
 
 void C3D_SafeMemoryFill(u32* buf0a, u32 buf0v, u32* buf0e, u16 control0, u32* buf1a, u32 buf1v, u32* buf1e, u16 control1)
 {
+	C3D_FrameFlushDeferred();
 	C3Di_WaitAndClearQueue(-1);
 	inSafeTransfer = true;
 	GX_MemoryFill(buf0a, buf0v, buf0e, control0, buf1a, buf1v, buf1e, control1);
@@ -0,0 +1,182 @@
+#include "internal.h"
+#include <c3d/spritebatch.h>
+#include <c3d/base.h>
+#include <stdlib.h>
+
+#define C3D_SPRITEBATCH_REGIONS (C3D_MAX_FRAME_LATENCY+1)
+
+static C3D_SpriteBatch* sortBatch;
+
+static int C3Di_SpriteCompare(const void* a, const void* b)
+{
+	u32 ia = *(const u32*)a, ib = *(const u32*)b;
+	const C3D_Sprite* sa = &sortBatch->sprites[ia];
+	const C3D_Sprite* sb = &sortBatch->sprites[ib];
+
+	if (sa->layer != sb->layer)
+		return sa->layer < sb->layer ? -1 : 1;
+	if (sa->tex != sb->tex)
+		return (uintptr_t)sa->tex < (uintptr_t)sb->tex ? -1 : 1;
+	// Keep submission order otherwise, qsort is not stable
+	return ia < ib ? -1 : ia > ib;
+}
+
+bool C3D_SpriteBatchInit(C3D_SpriteBatch* sb, int maxSprites)
+{
+	memset(sb, 0, sizeof(*sb));
+	if (maxSprites <= 0)
+		return false;
+
+	sb->sprites = (C3D_Sprite*)malloc(maxSprites*sizeof(C3D_Sprite));
+	sb->order = (u32*)malloc(maxSprites*sizeof(u32));
+	sb->vtx = (C3D_SpriteVertex*)linearAlloc(C3D_SPRITEBATCH_REGIONS*6*maxSprites*sizeof(C3D_SpriteVertex));
+	if (!sb->sprites || !sb->order || !sb->vtx)
+	{
+		C3D_SpriteBatchFree(sb);
+		return false;
+	}
+
+	sb->maxSprites = maxSprites;
+	return true;
+}
+
+void C3D_SpriteBatchFree(C3D_SpriteBatch* sb)
+{
+	free(sb->sprites);
+	free(sb->order);
+	if (sb->vtx)
+		linearFree(sb->vtx);
+	memset(sb, 0, sizeof(*sb));
+}
+
+void C3D_SpriteBatchBegin(C3D_SpriteBatch* sb)
+{
+	sb->numSprites = 0;
+}
+
+bool C3D_SpriteBatchDraw(C3D_SpriteBatch* sb, const C3D_Sprite* sprite)
+{
+	if (sb->numSprites == sb->maxSprites)
+		return false;
+	sb->sprites[sb->numSprites++] = *sprite;
+	return true;
+}
+
+static inline void C3Di_SpriteVertex(C3D_SpriteVertex* v, float x, float y, float z, float u, float t, u32 color)
+{
+	v->pos[0] = x;
+	v->pos[1] = y;
+	v->pos[2] = z;
+	v->uv[0] = u;
+	v->uv[1] = t;
+	v->color = color;
+}
+
+static void C3Di_SpriteQuad(C3D_SpriteVertex* v, const C3D_Sprite* s)
+{
+	// Corners relative to the pivot
+	float x0 = -s->pivotX*s->width, x1 = x0 + s->width;
+	float y0 = -s->pivotY*s->height, y1 = y0 + s->height;
+	float c = 1.0f, sn = 0.0f;
+	if (s->angle != 0.0f)
+	{
+		c = cosf(s->angle);
+		sn = sinf(s->angle);
+	}
+
+	float ax = s->x + x0*c - y0*sn, ay = s->y + x0*sn + y0*c; // top left
+	float bx = s->x + x1*c - y0*sn, by = s->y + x1*sn + y0*c; // top right
+	float cx = s->x + x0*c - y1*sn, cy = s->y + x0*sn + y1*c; // bottom left
+	float dx = s->x + x1*c - y1*sn, dy = s->y + x1*sn + y1*c; // bottom right
+	float z = s->depth;
+	u32 col = s->color;
+
+	C3Di_SpriteVertex(&v[0], ax, ay, z, s->u0, s->v0, col);
+	C3Di_SpriteVertex(&v[1], cx, cy, z, s->u0, s->v1, col);
+	C3Di_SpriteVertex(&v[2], bx, by, z, s->u1, s->v0, col);
+	C3Di_SpriteVertex(&v[3], bx, by, z, s->u1, s->v0, col);
+	C3Di_SpriteVertex(&v[4], cx, cy, z, s->u0, s->v1, col);
+	C3Di_SpriteVertex(&v[5], dx, dy, z, s->u1, s->v1, col);
+}
+
+static void C3Di_SpriteTexEnv(bool textured)
+{
+	C3D_TexEnv* env = C3D_GetTexEnv(0);
+	TexEnv_Init(env);
+	if (textured)
+	{
+		C3D_TexEnvSrc(env, C3D_Both, GPU_TEXTURE0, GPU_PRIMARY_COLOR, 0);
+		C3D_TexEnvFunc(env, C3D_Both, GPU_MODULATE);
+	}
+	else
+	{
+		C3D_TexEnvSrc(env, C3D_Both, GPU_PRIMARY_COLOR, 0, 0);
+		C3D_TexEnvFunc(env, C3D_Both, GPU_REPLACE);
+	}
+}
+
+void C3D_SpriteBatchEnd(C3D_SpriteBatch* sb)
+{
+	int i, n = sb->numSprites;
+	sb->lastDraws = 0;
+	sb->lastSprites = n;
+	if (!n)
+		return;
+
+	// A second batch in the same frame would reuse a region that an earlier
+	// frame still in flight may be reading
+	u32 frame = C3Di_FrameIndex();
+	if (sb->frame == frame)
+		svcBreak(USERBREAK_PANIC);
+	sb->frame = frame;
+
+	for (i = 0; i < n; i ++)
+		sb->order[i] = i;
+	sortBatch = sb;
+	qsort(sb->order, n, sizeof(u32), C3Di_SpriteCompare);
+	sortBatch = NULL;
+
+	// Each batch owns one region per frame in flight, so this frame's vertices
+	// never overwrite ones the GPU may still be reading
+	C3D_SpriteVertex* vtx = sb->vtx + sb->region*6*sb->maxSprites;
+	sb->region = (sb->region+1) % C3D_SPRITEBATCH_REGIONS;
+	for (i = 0; i < n; i ++)
+		C3Di_SpriteQuad(&vtx[6*i], &sb->sprites[sb->order[i]]);
+	GSPGPU_FlushDataCache(vtx, 6*n*sizeof(C3D_SpriteVertex));
+
+	C3D_AttrInfo* attrInfo = C3D_GetAttrInfo();
+	AttrInfo_Init(attrInfo);
+	AttrInfo_AddLoader(attrInfo, 0, GPU_FLOAT, 3);
+	AttrInfo_AddLoader(attrInfo, 1, GPU_FLOAT, 2);
+	AttrInfo_AddLoader(attrInfo, 2, GPU_UNSIGNED_BYTE, 4);
+
+	C3D_BufInfo* bufInfo = C3D_GetBufInfo();
+	BufInfo_Init(bufInfo);
+	BufInfo_Add(bufInfo, vtx, sizeof(C3D_SpriteVertex), 3, 0x210);
+
+	for (i = 1; i < 6; i ++)
+		TexEnv_Init(C3D_GetTexEnv(i));
+
+	// One draw per run of sprites sharing a texture
+	int textured = -1;
+	int first = 0;
+	while (first < n)
+	{
+		C3D_Tex* tex = sb->sprites[sb->order[first]].tex;
+		int last = first+1;
+		while (last < n && sb->sprites[sb->order[last]].tex == tex)
+			last ++;
+
+		if (textured != (tex != NULL))
+		{
+			textured = tex != NULL;
+			C3Di_SpriteTexEnv(textured);
+		}
+		if (tex)
+			C3D_TexBind(0, tex);
+
+		C3D_DrawArrays(GPU_TRIANGLES, 6*first, 6*(last-first));
+		sb->lastDraws ++;
+		first = last;
+	}
+}
@@ -53,6 +53,27 @@ void C3Di_TexEnvBind(int id, C3D_TexEnv* env)
 	GPUCMD_AddIncrementalWrites(GPUREG_TEXENV0_SOURCE + id*8, (u32*)env, sizeof(C3D_TexEnv)/sizeof(u32));
 }
 
+void C3Di_TexEnvUpdate(C3D_Context* ctx)
+{
+	int i;
+	C3D_TexEnv envs[6];
+	TexEnv_Optimize(envs, ctx->texEnv);
+
+	// Only stages whose effective configuration differs from the GPU's are sent
+	for (i = 0; i < 6; i ++)
+	{
+		C3D_TexEnv* env = &envs[i];
+		C3D_TexEnv* hw = &ctx->texEnvHw[i];
+		if (!(TexEnv_Sources(env) & BIT(GPU_CONSTANT)))
+			env->color = hw->color;
+		if ((ctx->texEnvHwValid & BIT(i)) && memcmp(env, hw, sizeof(*env)) == 0)
+			continue;
+		C3Di_TexEnvBind(i, env);
+		*hw = *env;
+	}
+	ctx->texEnvHwValid = 0x3F;
+}
+
 void C3D_TexEnvBufUpdate(int mode, int mask)
 {
 	C3D_Context* ctx = C3Di_GetContext();
@@ -89,3 +110,12 @@ void C3D_TexEnvBufColor(u32 color)
 	ctx->texEnvBufClr = color;
 	ctx->flags |= C3DiF_TexEnvBuf;
 }
+
+void C3D_TexEnvGetModel(C3D_TexEnvModel* model)
+{
+	C3D_Context* ctx = C3Di_GetContext();
+
+	memcpy(model->env, ctx->texEnv, sizeof(model->env));
+	model->bufUpdate = ctx->texEnvBuf;
+	model->bufColor  = ctx->texEnvBufClr;
+}
@@ -0,0 +1,412 @@
+#include <c3d/texenvmodel.h>
+#include <string.h>
+
+// GPU_TEVSRC values
+enum
+{
+	SRC_PRIMARY_COLOR, SRC_FRAGMENT_PRIMARY, SRC_FRAGMENT_SECONDARY,
+	SRC_TEXTURE0, SRC_TEXTURE1, SRC_TEXTURE2, SRC_TEXTURE3,
+	SRC_PREVIOUS_BUFFER = 0xD, SRC_CONSTANT, SRC_PREVIOUS,
+};
+
+// GPU_COMBINEFUNC values
+enum
+{
+	FUNC_REPLACE, FUNC_MODULATE, FUNC_ADD, FUNC_ADD_SIGNED, FUNC_INTERPOLATE,
+	FUNC_SUBTRACT, FUNC_DOT3_RGB, FUNC_DOT3_RGBA, FUNC_MULTIPLY_ADD, FUNC_ADD_MULTIPLY,
+};
+
+// Input slots of a fragment, everything a source can refer to
+enum { IN_PREVIOUS_BUFFER = 7, IN_CONSTANT, IN_PREVIOUS, IN_ZERO, IN_COUNT };
+
+typedef struct
+{
+	u8 src[3][2];    // Input slot per argument, RGB and alpha
+	u8 opRgb[3];
+	u8 opAlpha[3];
+	u8 funcRgb, funcAlpha;
+	u8 scaleRgb, scaleAlpha;
+	u8 bufRgb, bufAlpha;
+} Stage;
+
+static inline int srcSlot(int src)
+{
+	if (src <= SRC_TEXTURE3) return src;
+	if (src >= SRC_PREVIOUS_BUFFER) return IN_PREVIOUS_BUFFER + src - SRC_PREVIOUS_BUFFER;
+	return IN_ZERO;
+}
+
+static inline int minInt(int a, int b) { return a < b ? a : b; }
+static inline int maxInt(int a, int b) { return a > b ? a : b; }
+
+// GPU_TEVOP_RGB, values not listed in the enum read as the plain color
+static void opRgb(int* out, const u8* c, int op)
+{
+	int i;
+	switch (op >> 2)
+	{
+		case 0:
+			if (op & 2)
+				out[0] = out[1] = out[2] = c[3];
+			else
+				for (i = 0; i < 3; i ++) out[i] = c[i];
+			break;
+		case 1: out[0] = out[1] = out[2] = c[0]; break;
+		case 2: out[0] = out[1] = out[2] = c[1]; break;
+		case 3: out[0] = out[1] = out[2] = c[2]; break;
+	}
+	if (op & 1)
+		for (i = 0; i < 3; i ++) out[i] = 255 - out[i];
+}
+
+// GPU_TEVOP_A: alpha, red, green, blue and their complements
+static inline int opAlpha(const u8* c, int op)
+{
+	static const u8 channel[4] = { 3, 0, 1, 2 };
+	int v = c[channel[(op >> 1) & 3]];
+	return (op & 1) ? 255 - v : v;
+}
+
+static inline int dot3Term(int a, int b)
+{
+	return ((a*2 - 255)*(b*2 - 255) + 128) / 256;
+}
+
+static inline int combine(int func, int a, int b, int c)
+{
+	switch (func)
+	{
+		default:
+		case FUNC_REPLACE:      return a;
+		case FUNC_MODULATE:     return a*b / 255;
+		case FUNC_ADD:          return minInt(a + b, 255);
+		case FUNC_ADD_SIGNED:   return minInt(maxInt(a + b - 128, 0), 255);
+		case FUNC_INTERPOLATE:  return (a*c + b*(255 - c)) / 255;
+		case FUNC_SUBTRACT:     return maxInt(a - b, 0);
+		case FUNC_MULTIPLY_ADD: return minInt((a*b + 255*c) / 255, 255);
+		case FUNC_ADD_MULTIPLY: return minInt(a + b, 255)*c / 255;
+	}
+}
+
+// GPU_TEVSCALE as a shift, the reserved value 3 acts like GPU_TEVSCALE_1
+static inline int scaleShift(int s)
+{
+	s &= 3;
+	return s == 3 ? 0 : s;
+}
+
+static inline int scale(int v, int s)
+{
+	return minInt(v << s, 255);
+}
+
+void TexEnvModel_Eval(const C3D_TexEnvModel* m, u32* out, const C3D_TexEnvInputs* in, int count)
+{
+	int i, j, k;
+	Stage stages[6];
+
+	// Split the packed source, operand and scale fields per stage
+	for (k = 0; k < 6; k ++)
+	{
+		const C3D_TexEnv* env = &m->env[k];
+		Stage* s = &stages[k];
+		for (j = 0; j < 3; j ++)
+		{
+			s->src[j][0] = srcSlot((env->srcRgb >> (j*4)) & 0xF);
+			s->src[j][1] = srcSlot((env->srcAlpha >> (j*4)) & 0xF);
+			s->opRgb[j]   = (env->opRgb >> (j*4)) & 0xF;
+			s->opAlpha[j] = (env->opAlpha >> (j*4)) & 0x7;
+		}
+		s->funcRgb    = env->funcRgb & 0xF;
+		s->funcAlpha  = env->funcAlpha & 0xF;
+		s->scaleRgb   = scaleShift(env->scaleRgb);
+		s->scaleAlpha = scaleShift(env->scaleAlpha);
+		s->bufRgb     = k < 4 && (m->bufUpdate & BIT(8+k));
+		s->bufAlpha   = k < 4 && (m->bufUpdate & BIT(12+k));
+	}
+
+	for (i = 0; i < count; i ++)
+	{
+		u8 c[IN_COUNT][4];
+		const u32 colors[7] = { in[i].primary, in[i].fragPrimary, in[i].fragSecondary,
+			in[i].tex[0], in[i].tex[1], in[i].tex[2], in[i].tex[3] };
+		for (j = 0; j < 7; j ++)
+			for (k = 0; k < 4; k ++)
+				c[j][k] = colors[j] >> (k*8);
+		for (k = 0; k < 4; k ++)
+		{
+			c[IN_PREVIOUS_BUFFER][k] = 0;
+			c[IN_PREVIOUS][k] = 0;
+			c[IN_ZERO][k] = 0;
+		}
+
+		u8 nextBuf[4];
+		for (k = 0; k < 4; k ++)
+			nextBuf[k] = m->bufColor >> (k*8);
+
+		for (j = 0; j < 6; j ++)
+		{
+			const Stage* s = &stages[j];
+			for (k = 0; k < 4; k ++)
+				c[IN_CONSTANT][k] = m->env[j].color >> (k*8);
+
+			int arg[3][3], a[3];
+			for (k = 0; k < 3; k ++)
+			{
+				opRgb(arg[k], c[s->src[k][0]], s->opRgb[k]);
+				a[k] = opAlpha(c[s->src[k][1]], s->opAlpha[k]);
+			}
+
+			int rgb[3], alpha;
+			if (s->funcRgb == FUNC_DOT3_RGB || s->funcRgb == FUNC_DOT3_RGBA)
+			{
+				int d = dot3Term(arg[0][0], arg[1][0]) + dot3Term(arg[0][1], arg[1][1]) + dot3Term(arg[0][2], arg[1][2]);
+				rgb[0] = rgb[1] = rgb[2] = minInt(maxInt(d, 0), 255);
+			} else
+				for (k = 0; k < 3; k ++)
+					rgb[k] = combine(s->funcRgb, arg[0][k], arg[1][k], arg[2][k]);
+
+			if (s->funcRgb == FUNC_DOT3_RGBA)
+				alpha = rgb[0];
+			else if (s->funcAlpha == FUNC_DOT3_RGB || s->funcAlpha == FUNC_DOT3_RGBA)
+				alpha = minInt(maxInt(3*dot3Term(a[0], a[1]), 0), 255);
+			else
+				alpha = combine(s->funcAlpha, a[0], a[1], a[2]);
+
+			for (k = 0; k < 3; k ++)
+				c[IN_PREVIOUS][k] = scale(rgb[k], s->scaleRgb);
+			c[IN_PREVIOUS][3] = scale(alpha, s->scaleAlpha);
+
+			// The buffer lags one stage behind its updates
+			memcpy(c[IN_PREVIOUS_BUFFER], nextBuf, 4);
+			if (s->bufRgb)
+				memcpy(nextBuf, c[IN_PREVIOUS], 3);
+			if (s->bufAlpha)
+				nextBuf[3] = c[IN_PREVIOUS][3];
+		}
+
+		const u8* o = c[IN_PREVIOUS];
+		out[i] = o[0] | (o[1] << 8) | (o[2] << 16) | ((u32)o[3] << 24);
+	}
+}
+
+// Arguments each GPU_COMBINEFUNC takes, unknown values act like GPU_REPLACE
+static const u8 numArgs[16] = { 1, 2, 2, 2, 3, 2, 2, 2, 3, 3, 1, 1, 1, 1, 1, 1 };
+
+static inline int rgbArgs(const C3D_TexEnv* env)
+{
+	return numArgs[env->funcRgb & 0xF];
+}
+
+static inline int alphaArgs(const C3D_TexEnv* env)
+{
+	return env->funcRgb == FUNC_DOT3_RGBA ? 0 : numArgs[env->funcAlpha & 0xF];
+}
+
+static inline bool rgbPassthrough(const C3D_TexEnv* env)
+{
+	return env->funcRgb == FUNC_REPLACE && (env->srcRgb & 0xF) == SRC_PREVIOUS
+		&& (env->opRgb & 0xF) == 0 && !scaleShift(env->scaleRgb);
+}
+
+static inline bool alphaPassthrough(const C3D_TexEnv* env)
+{
+	return env->funcAlpha == FUNC_REPLACE && env->funcRgb != FUNC_DOT3_RGBA
+		&& (env->srcAlpha & 0xF) == SRC_PREVIOUS && (env->opAlpha & 0x7) == 0 && !scaleShift(env->scaleAlpha);
+}
+
+bool TexEnv_IsPassthrough(const C3D_TexEnv* env)
+{
+	// Replace with the unmodified previous color at scale 1
+	return rgbPassthrough(env) && alphaPassthrough(env);
+}
+
+u32 TexEnv_Sources(const C3D_TexEnv* env)
+{
+	int j;
+	u32 srcs = 0;
+	for (j = 0; j < rgbArgs(env); j ++)
+		srcs |= BIT((env->srcRgb >> (j*4)) & 0xF);
+	for (j = 0; j < alphaArgs(env); j ++)
+		srcs |= BIT((env->srcAlpha >> (j*4)) & 0xF);
+	return srcs;
+}
+
+// Channels of a source read by one half of a stage, bit 0 for RGB and bit 1 for alpha
+static int halfReads(const C3D_TexEnv* env, bool alpha, int src)
+{
+	int j, mask = 0;
+	if (!alpha)
+	{
+		for (j = 0; j < rgbArgs(env); j ++)
+		{
+			if (((env->srcRgb >> (j*4)) & 0xF) != src) continue;
+			int op = (env->opRgb >> (j*4)) & 0xF;
+			mask |= (op & 0xE) == 2 ? 2 : 1;
+		}
+	} else
+	{
+		for (j = 0; j < alphaArgs(env); j ++)
+		{
+			if (((env->srcAlpha >> (j*4)) & 0xF) != src) continue;
+			int op = (env->opAlpha >> (j*4)) & 0x7;
+			mask |= op < 2 ? 2 : 1;
+		}
+	}
+	return mask;
+}
+
+static void setPassthrough(C3D_TexEnv* env)
+{
+	env->srcRgb = env->srcAlpha = SRC_PREVIOUS;
+	env->opRgb = env->opAlpha = 0;
+	env->funcRgb = env->funcAlpha = FUNC_REPLACE;
+	env->color = 0xFFFFFFFF;
+	env->scaleRgb = env->scaleAlpha = 0;
+}
+
+// Clears the sources and operands of arguments the functions don't take
+static void canonicalize(C3D_TexEnv* env)
+{
+	static const u16 masks[4] = { 0x000, 0x00F, 0x0FF, 0xFFF };
+	if (env->funcRgb == FUNC_DOT3_RGBA)
+		env->funcAlpha = FUNC_REPLACE;
+	env->srcRgb   &= masks[rgbArgs(env)];
+	env->opRgb    &= masks[rgbArgs(env)];
+	env->srcAlpha &= masks[alphaArgs(env)];
+	env->opAlpha  &= masks[alphaArgs(env)];
+}
+
+static int nextLive(const C3D_TexEnv* envs, int k)
+{
+	for (k ++; k < 6; k ++)
+		if (!TexEnv_IsPassthrough(&envs[k]))
+			return k;
+	return -1;
+}
+
+static void replaceSource(C3D_TexEnv* env, int from, int to)
+{
+	int j;
+	for (j = 0; j < rgbArgs(env); j ++)
+		if (((env->srcRgb >> (j*4)) & 0xF) == from)
+			env->srcRgb = (env->srcRgb &~ (0xF << (j*4))) | (to << (j*4));
+	for (j = 0; j < alphaArgs(env); j ++)
+		if (((env->srcAlpha >> (j*4)) & 0xF) == from)
+			env->srcAlpha = (env->srcAlpha &~ (0xF << (j*4))) | (to << (j*4));
+}
+
+// Output of a stage that only reads its constant color
+static u32 constantOutput(const C3D_TexEnv* env)
+{
+	int k;
+	u32 out;
+	C3D_TexEnvModel m;
+	C3D_TexEnvInputs in;
+	memset(&m, 0, sizeof(m));
+	memset(&in, 0, sizeof(in));
+	m.env[0] = *env;
+	for (k = 1; k < 6; k ++)
+		setPassthrough(&m.env[k]);
+	TexEnvModel_Eval(&m, &out, &in, 1);
+	return out;
+}
+
+// One stage doing the RGB work of a and the alpha work of b, which follows a
+static bool mergeHalves(C3D_TexEnv* out, const C3D_TexEnv* a, const C3D_TexEnv* b, bool bIsAlpha)
+{
+	// The later half may only look at its own channels of the previous color
+	if (halfReads(b, bIsAlpha, SRC_PREVIOUS) & (bIsAlpha ? 1 : 2))
+		return false;
+
+	const C3D_TexEnv* rgb = bIsAlpha ? a : b;
+	const C3D_TexEnv* alpha = bIsAlpha ? b : a;
+	bool rgbConst = (TexEnv_Sources(rgb) & BIT(SRC_CONSTANT)) != 0;
+	bool alphaConst = (TexEnv_Sources(alpha) & BIT(SRC_CONSTANT)) != 0;
+	if (rgbConst && alphaConst && rgb->color != alpha->color)
+		return false;
+
+	C3D_TexEnv merged = *rgb;
+	merged.srcAlpha   = alpha->srcAlpha;
+	merged.opAlpha    = alpha->opAlpha;
+	merged.funcAlpha  = alpha->funcAlpha;
+	merged.scaleAlpha = alpha->scaleAlpha;
+	if (alphaConst)
+		merged.color = alpha->color;
+	*out = merged;
+	return true;
+}
+
+void TexEnv_Optimize(C3D_TexEnv* out, const C3D_TexEnv* in)
+{
+	int k, next;
+	u32 srcs = 0;
+
+	memcpy(out, in, 6*sizeof(C3D_TexEnv));
+	for (k = 0; k < 6; k ++)
+	{
+		canonicalize(&out[k]);
+		srcs |= TexEnv_Sources(&out[k]);
+	}
+
+	// The combiner buffer ties its contents to stage positions, leave those alone
+	if (srcs & BIT(SRC_PREVIOUS_BUFFER))
+		return;
+
+	// Stages reading only their constant color become that color, which the
+	// next stage can take in place of its previous input
+	for (k = 0; k < 6; k ++)
+	{
+		C3D_TexEnv* env = &out[k];
+		if (TexEnv_IsPassthrough(env) || TexEnv_Sources(env) != BIT(SRC_CONSTANT))
+			continue;
+		if (env->funcRgb == FUNC_DOT3_RGB || env->funcRgb == FUNC_DOT3_RGBA
+			|| env->funcAlpha == FUNC_DOT3_RGB || env->funcAlpha == FUNC_DOT3_RGBA)
+			continue; // Not modeled exactly
+
+		u32 color = constantOutput(env);
+		setPassthrough(env);
+		env->srcRgb = env->srcAlpha = SRC_CONSTANT;
+		env->color = color;
+
+		next = nextLive(out, k);
+		if (next < 0) continue;
+		u32 nextSrcs = TexEnv_Sources(&out[next]);
+		if (!(nextSrcs & BIT(SRC_PREVIOUS)) || ((nextSrcs & BIT(SRC_CONSTANT)) && out[next].color != color))
+			continue;
+		replaceSource(&out[next], SRC_PREVIOUS, SRC_CONSTANT);
+		out[next].color = color;
+	}
+
+	// Drop stages whose output nothing reads, the last one feeds the framebuffer
+	bool needed = true;
+	for (k = 5; k >= 0; k --)
+	{
+		if (TexEnv_IsPassthrough(&out[k])) continue;
+		if (!needed)
+			setPassthrough(&out[k]);
+		else
+			needed = (TexEnv_Sources(&out[k]) & BIT(SRC_PREVIOUS)) != 0;
+	}
+
+	// Adjacent stages working on opposite halves share one stage
+	for (k = nextLive(out, -1); k >= 0 && (next = nextLive(out, k)) >= 0;)
+	{
+		C3D_TexEnv* a = &out[k];
+		C3D_TexEnv* b = &out[next];
+		bool aRgb = alphaPassthrough(a), aAlpha = rgbPassthrough(a);
+		bool bRgb = alphaPassthrough(b), bAlpha = rgbPassthrough(b);
+		if (((aRgb && bAlpha) || (aAlpha && bRgb)) && mergeHalves(a, a, b, bAlpha))
+			setPassthrough(b);
+		else
+			k = next;
+	}
+
+	// Move the remaining stages to the front so that the trailing ones match
+	// across materials and need no writes
+	for (k = next = 0; k < 6; k ++)
+		if (!TexEnv_IsPassthrough(&out[k]))
+			out[next++] = out[k];
+	for (; next < 6; next ++)
+		setPassthrough(&out[next]);
+}
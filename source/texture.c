@@ -57,16 +57,36 @@ static void C3Di_TexCubeDelete(C3D_TexCube* cube)
 	}
 }
 
-bool C3D_TexInitWithParams(C3D_Tex* tex, C3D_TexCube* cube, C3D_TexInitParams p)
+static u32 C3Di_TexLevelSize(C3D_TexInitParams p)
 {
-	if ((p.width|p.height) & 7) return false;
+	if ((p.width|p.height) & 7) return 0;
+	return fmtSize(p.format) * p.width * p.height / 8;
+}
 
+static void C3Di_TexSetup(C3D_Tex* tex, C3D_TexInitParams p, u32 size)
+{
+	tex->width = p.width;
+	tex->height = p.height;
+	tex->param = GPU_TEXTURE_MODE(p.type);
+	if (p.format == GPU_ETC1)
+		tex->param |= GPU_TEXTURE_ETC1_PARAM;
+	if (p.type == GPU_TEX_SHADOW_2D || p.type == GPU_TEX_SHADOW_CUBE)
+		tex->param |= GPU_TEXTURE_SHADOW_PARAM;
+	tex->fmt = p.format;
+	tex->size = size;
+	tex->border = 0;
+	tex->lodBias = 0;
+	tex->maxLevel = p.maxLevel;
+	tex->minLevel = 0;
+}
+
+bool C3D_TexInitWithParams(C3D_Tex* tex, C3D_TexCube* cube, C3D_TexInitParams p)
+{
 	bool isCube = typeIsCube(p.type);
 	if (isCube && !cube) return false;
 
-	u32 size = fmtSize(p.format);
+	u32 size = C3Di_TexLevelSize(p);
 	if (!size) return false;
-	size *= (u32)p.width * p.height / 8;
 	u32 total_size = C3D_TexCalcTotalSize(size, p.maxLevel);
 
 	if (!isCube)
@@ -90,22 +110,22 @@ bool C3D_TexInitWithParams(C3D_Tex* tex, C3D_TexCube* cube, C3D_TexInitParams p)
 		tex->cube = cube;
 	}
 
-	tex->width = p.width;
-	tex->height = p.height;
-	tex->param = GPU_TEXTURE_MODE(p.type);
-	if (p.format == GPU_ETC1)
-		tex->param |= GPU_TEXTURE_ETC1_PARAM;
-	if (p.type == GPU_TEX_SHADOW_2D || p.type == GPU_TEX_SHADOW_CUBE)
-		tex->param |= GPU_TEXTURE_SHADOW_PARAM;
-	tex->fmt = p.format;
-	tex->size = size;
-	tex->border = 0;
-	tex->lodBias = 0;
-	tex->maxLevel = p.maxLevel;
-	tex->minLevel = 0;
+	C3Di_TexSetup(tex, p, size);
 	return true;
 }
 
+u32 C3Di_TexInitPlaced(C3D_Tex* tex, void* data, C3D_TexInitParams p)
+{
+	if (typeIsCube(p.type)) return 0;
+
+	u32 size = C3Di_TexLevelSize(p);
+	if (!size) return 0;
+
+	tex->data = data;
+	C3Di_TexSetup(tex, p, size);
+	return C3D_TexCalcTotalSize(size, p.maxLevel);
+}
+
 void C3D_TexLoadImage(C3D_Tex* tex, const void* data, GPU_TEXFACE face, int level)
 {
 	u32 size = 0;
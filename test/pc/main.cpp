@@ -1,8 +1,13 @@
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <random>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -11,6 +16,16 @@
 
 extern "C" {
 #include <c3d/maths.h>
+#include <c3d/dynres.h>
+#include <c3d/bvh.h>
+#include <c3d/anim.h>
+#include <c3d/floatpack.h>
+#include <c3d/lightlut.h>
+#include <c3d/lightmodel.h>
+#include <c3d/texenvmodel.h>
+#include <c3d/lightgrid.h>
+#include <c3d/renderplan.h>
+#include <c3d/foglut.h>
 }
 
 typedef std::default_random_engine            generator_t;
@@ -964,6 +979,1647 @@ check_quaternion(generator_t &gen, distribution_t &dist)
   }
 }
 
+template<typename F>
+static double
+benchNs(int count, int iterations, F func)
+{
+  auto start = std::chrono::steady_clock::now();
+  for(int i = 0; i < iterations; ++i)
+    func();
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / (static_cast<double>(count) * iterations);
+}
+
+static void
+bench_transform(generator_t &gen, distribution_t &dist)
+{
+  const int count = 4096, iterations = 2000;
+
+  C3D_Mtx m;
+  randomMatrix(m, gen, dist);
+  glm::mat4 g = loadMatrix(m);
+
+  std::vector<C3D_FVec>  vin(count), vout(count);
+  std::vector<glm::vec4> gin(count), gout(count);
+  std::vector<float>     pin(count*3), pout(count*3);
+  for(int i = 0; i < count; ++i)
+  {
+    vin[i] = FVec4_New(dist(gen), dist(gen), dist(gen), 1.0f);
+    gin[i] = glm::vec4(vin[i].x, vin[i].y, vin[i].z, 1.0f);
+    pin[i*3+0] = vin[i].x;
+    pin[i*3+1] = vin[i].y;
+    pin[i*3+2] = vin[i].z;
+  }
+
+  printf("transform (ns/vertex)\n");
+  printf("  Mtx_MultiplyFVec4         %6.2f\n", benchNs(count, iterations, [&]{
+    for(int i = 0; i < count; ++i)
+      vout[i] = Mtx_MultiplyFVec4(&m, vin[i]);
+  }));
+  printf("  Mtx_MultiplyFVec4Array    %6.2f\n", benchNs(count, iterations, [&]{
+    Mtx_MultiplyFVec4Array(&m, vout.data(), vin.data(), count);
+  }));
+  printf("  Mtx_TransformPointsAffine %6.2f\n", benchNs(count, iterations, [&]{
+    Mtx_TransformPointsAffine(&m, pout.data(), pin.data(), count);
+  }));
+  printf("  glm::mat4 * glm::vec4     %6.2f\n", benchNs(count, iterations, [&]{
+    for(int i = 0; i < count; ++i)
+      gout[i] = g * gin[i];
+  }));
+}
+
+static void
+check_dynres(generator_t &gen, distribution_t &dist)
+{
+  static const float cost[] = { 1.0f, 0.5f, 0.25f };
+
+  // stays at full resolution while under budget
+  {
+    C3D_DynRes dr;
+    DynRes_Init(&dr, 16.0f);
+    DynRes_SetLevels(&dr, cost, 3);
+
+    for(size_t i = 0; i < 100; ++i)
+      assert(DynRes_Update(&dr, 10.0f) == 0);
+  }
+
+  // drops straight to the first level predicted to fit, then recovers
+  {
+    C3D_DynRes dr;
+    DynRes_Init(&dr, 16.0f);
+    DynRes_SetLevels(&dr, cost, 3);
+    dr.smoothing = 1.0f;
+
+    assert(DynRes_Update(&dr, 40.0f) == 2);
+    assert(DynRes_Update(&dr, 10.0f) == 2);
+
+    // 4ms at level 2 predicts 8ms at level 1, which has enough headroom
+    int level = 2;
+    size_t frames = 0;
+    while(level == 2)
+    {
+      level = DynRes_Update(&dr, 4.0f);
+      ++frames;
+    }
+    assert(level == 1);
+    assert(frames == static_cast<size_t>(dr.upDelay));
+  }
+
+  // never leaves the configured range and never oscillates every frame
+  {
+    C3D_DynRes dr;
+    DynRes_Init(&dr, 16.0f);
+    DynRes_SetLevels(&dr, cost, 3);
+
+    int last = 0, changes = 0;
+    for(size_t i = 0; i < 10000; ++i)
+    {
+      // synthetic workload: pixel-bound time plus noise
+      float time = 24.0f*cost[dr.level] + std::abs(dist(gen))*0.2f;
+      int level = DynRes_Update(&dr, time);
+      assert(level >= 0 && level < 3);
+      if(level != last)
+        ++changes;
+      last = level;
+    }
+    assert(changes < 10000/dr.upDelay);
+  }
+}
+
+static bool
+insideClip(const C3D_Mtx &mvp, const C3D_FVec &p, float margin)
+{
+  C3D_FVec c = Mtx_MultiplyFVecH(&mvp, p);
+  float    m = std::abs(c.w)*margin;
+
+  return c.x >= -c.w+m && c.x <= c.w-m
+      && c.y >= -c.w+m && c.y <= c.w-m
+      && c.z >= -c.w+m && c.z <= -m;
+}
+
+static bool
+outsideClip(const C3D_Mtx &mvp, const C3D_FVec &p, float margin)
+{
+  C3D_FVec c = Mtx_MultiplyFVecH(&mvp, p);
+  float    m = std::abs(c.w)*margin;
+
+  return c.x < -c.w-m || c.x > c.w+m
+      || c.y < -c.w-m || c.y > c.w+m
+      || c.z < -c.w-m || c.z > m;
+}
+
+static void
+check_frustum(generator_t &gen, distribution_t &dist)
+{
+  static const int count = 1003; // not a multiple of the SIMD width
+
+  for(size_t n = 0; n < 5; ++n)
+  {
+    C3D_Mtx proj, view, mvp;
+    switch(n)
+    {
+      case 0: Mtx_Persp(&proj, C3D_AngleFromDegrees(60.0f), C3D_AspectRatioTop, 0.1f, 50.0f, false); break;
+      case 1: Mtx_PerspTilt(&proj, C3D_AngleFromDegrees(60.0f), C3D_AspectRatioTop, 0.1f, 50.0f, false); break;
+      case 2: Mtx_PerspStereoTilt(&proj, C3D_AngleFromDegrees(60.0f), C3D_AspectRatioTop, 0.1f, 50.0f, -0.5f, 2.0f, true); break;
+      case 3: Mtx_Ortho(&proj, -8.0f, 8.0f, -6.0f, 6.0f, 0.0f, 30.0f, false); break;
+      case 4: Mtx_OrthoTilt(&proj, -8.0f, 8.0f, -6.0f, 6.0f, 0.0f, 30.0f, true); break;
+    }
+    Mtx_LookAt(&view, FVec3_New(dist(gen), dist(gen), dist(gen)), FVec3_New(0.0f, 0.0f, 0.0f), FVec3_New(0.0f, 1.0f, 0.0f), n == 2 || n == 4);
+    Mtx_Multiply(&mvp, &proj, &view);
+
+    C3D_Frustum f;
+    Mtx_ExtractFrustum(&f, &mvp);
+
+    // planes agree with the clip space test
+    for(size_t i = 0; i < 10000; ++i)
+    {
+      C3D_FVec p = FVec3_New(dist(gen)*3.0f, dist(gen)*3.0f, dist(gen)*3.0f);
+      bool inside = true;
+      for(size_t j = 0; j < 6; ++j)
+        inside = inside && Frustum_PlaneDistance(f.planes[j], p) >= 0.0f;
+
+      if(insideClip(mvp, p, 0.001f))
+        assert(inside);
+      else if(outsideClip(mvp, p, 0.001f))
+        assert(!inside);
+    }
+
+    std::vector<C3D_FVec> spheres(count);
+    std::vector<C3D_AABB> boxes(count);
+    for(size_t i = 0; i < count; ++i)
+    {
+      C3D_FVec c = FVec3_New(dist(gen)*4.0f, dist(gen)*4.0f, dist(gen)*4.0f);
+      C3D_FVec e = FVec3_New(std::abs(dist(gen))*0.3f, std::abs(dist(gen))*0.3f, std::abs(dist(gen))*0.3f);
+      spheres[i] = FVec4_New(c.x, c.y, c.z, FVec3_Magnitude(e));
+      boxes[i].min = FVec3_Subtract(c, e);
+      boxes[i].max = FVec3_Add(c, e);
+    }
+
+    std::vector<u32> visible(count), culled(count);
+
+    // spheres: visible and culled lists partition the input in order, match the
+    // single sphere test, and never cull a sphere with a point inside the frustum
+    int numVisible = Frustum_CullSpheres(&f, spheres.data(), count, visible.data(), culled.data());
+    assert(numVisible > 0 && numVisible < count);
+    for(int i = 0, v = 0, c = 0; i < count; ++i)
+    {
+      bool isVisible = v < numVisible && visible[v] == static_cast<u32>(i);
+      if(isVisible)
+        ++v;
+      else
+        assert(culled[c++] == static_cast<u32>(i));
+
+      assert(isVisible == Frustum_TestSphere(&f, spheres[i]));
+      if(!isVisible)
+      {
+        for(size_t j = 0; j < 50; ++j)
+        {
+          C3D_FVec d = FVec3_Normalize(FVec3_New(dist(gen), dist(gen), dist(gen)));
+          C3D_FVec p = FVec3_Add(spheres[i], FVec3_Scale(d, spheres[i].w*std::abs(dist(gen))/10.0f));
+          assert(!insideClip(mvp, p, 0.001f));
+        }
+      }
+    }
+    assert(Frustum_CullSpheres(&f, spheres.data(), count, nullptr, nullptr) == numVisible);
+
+    // boxes: same properties
+    numVisible = Frustum_CullAABBs(&f, boxes.data(), count, visible.data(), culled.data());
+    assert(numVisible > 0 && numVisible < count);
+    for(int i = 0, v = 0, c = 0; i < count; ++i)
+    {
+      bool isVisible = v < numVisible && visible[v] == static_cast<u32>(i);
+      if(isVisible)
+        ++v;
+      else
+        assert(culled[c++] == static_cast<u32>(i));
+
+      assert(isVisible == Frustum_TestAABB(&f, &boxes[i]));
+      if(!isVisible)
+      {
+        for(size_t j = 0; j < 50; ++j)
+        {
+          float tx = (dist(gen)+10.0f)/20.0f, ty = (dist(gen)+10.0f)/20.0f, tz = (dist(gen)+10.0f)/20.0f;
+          C3D_FVec p = FVec3_New(boxes[i].min.x + (boxes[i].max.x-boxes[i].min.x)*tx,
+                                 boxes[i].min.y + (boxes[i].max.y-boxes[i].min.y)*ty,
+                                 boxes[i].min.z + (boxes[i].max.z-boxes[i].min.z)*tz);
+          assert(!insideClip(mvp, p, 0.001f));
+        }
+      }
+    }
+  }
+}
+
+static float
+boundaryDistance(const C3D_Frustum &f, const C3D_FVec &s)
+{
+  float d = INFINITY;
+  for(size_t j = 0; j < 6; ++j)
+    d = std::min(d, std::abs(Frustum_PlaneDistance(f.planes[j], s) + s.w));
+  return d;
+}
+
+static void
+check_frustum_stereo(generator_t &gen, distribution_t &dist)
+{
+  static const int count = 2000;
+
+  for(size_t n = 0; n < 4; ++n)
+  {
+    float iod    = n*0.4f;
+    float screen = n == 3 ? 60.0f : 2.0f; // n == 3: eyes converge beyond the far plane
+    C3D_Mtx proj[2], view, mvp[2];
+    for(size_t e = 0; e < 2; ++e)
+    {
+      if(n & 1)
+        Mtx_PerspStereoTilt(&proj[e], C3D_AngleFromDegrees(40.0f), C3D_AspectRatioTop, 0.1f, 30.0f, e ? iod : -iod, screen, false);
+      else
+        Mtx_PerspStereo(&proj[e], C3D_AngleFromDegrees(40.0f), C3D_AspectRatioTop, 0.1f, 30.0f, e ? iod : -iod, screen, false);
+    }
+    Mtx_LookAt(&view, FVec3_New(dist(gen), dist(gen), dist(gen)), FVec3_New(0.0f, 0.0f, 0.0f), FVec3_New(0.0f, 1.0f, 0.0f), false);
+    for(size_t e = 0; e < 2; ++e)
+      Mtx_Multiply(&mvp[e], &proj[e], &view);
+
+    C3D_StereoFrustum f;
+    Mtx_ExtractFrustumStereo(&f, &mvp[0], &mvp[1]);
+
+    // near and far are always shared, with no separation every plane is
+    assert((f.sharedPlanes & 0x30) == 0x30);
+    if(n == 0)
+      assert(f.sharedPlanes == 0x3F);
+
+    // points inside either eye are inside the union
+    for(size_t i = 0; i < 10000; ++i)
+    {
+      C3D_FVec p = FVec3_New(dist(gen)*3.0f, dist(gen)*3.0f, dist(gen)*3.0f);
+      if(insideClip(mvp[0], p, 0.001f) || insideClip(mvp[1], p, 0.001f))
+      {
+        for(size_t j = 0; j < 6; ++j)
+          assert(Frustum_PlaneDistance(f.both.planes[j], p) >= 0.0f);
+      }
+    }
+
+    std::vector<C3D_FVec> spheres(count);
+    std::vector<C3D_AABB> boxes(count);
+    for(size_t i = 0; i < count; ++i)
+    {
+      C3D_FVec c = FVec3_New(dist(gen)*3.0f, dist(gen)*3.0f, dist(gen)*3.0f);
+      C3D_FVec e = FVec3_New(std::abs(dist(gen))*0.05f, std::abs(dist(gen))*0.05f, std::abs(dist(gen))*0.05f);
+      spheres[i] = FVec4_New(c.x, c.y, c.z, FVec3_Magnitude(e));
+      boxes[i].min = FVec3_Subtract(c, e);
+      boxes[i].max = FVec3_Add(c, e);
+    }
+
+    // masks match culling each eye separately, away from the plane boundaries
+    std::vector<u8> masks(count);
+    int numVisible = Frustum_CullSpheresStereo(&f, spheres.data(), count, masks.data());
+    int expected = 0, mono = 0;
+    for(size_t i = 0; i < count; ++i)
+    {
+      bool left  = Frustum_TestSphere(&f.eye[0], spheres[i]);
+      bool right = Frustum_TestSphere(&f.eye[1], spheres[i]);
+      if(left || right)
+        ++expected;
+      if(left != right)
+        ++mono;
+
+      if(boundaryDistance(f.eye[0], spheres[i]) < 0.001f || boundaryDistance(f.eye[1], spheres[i]) < 0.001f)
+        continue;
+      assert(!!(masks[i] & C3D_STEREO_LEFT) == left);
+      assert(!!(masks[i] & C3D_STEREO_RIGHT) == right);
+    }
+    assert(std::abs(numVisible - expected) <= count/100);
+    if(n == 0)
+      assert(mono == 0);
+
+    Frustum_CullAABBsStereo(&f, boxes.data(), count, masks.data());
+    for(size_t i = 0; i < count; ++i)
+    {
+      if(masks[i] & C3D_STEREO_LEFT)
+        assert(Frustum_TestSphere(&f.eye[0], spheres[i]) || boundaryDistance(f.eye[0], spheres[i]) < 0.001f);
+      if(masks[i] & C3D_STEREO_RIGHT)
+        assert(Frustum_TestSphere(&f.eye[1], spheres[i]) || boundaryDistance(f.eye[1], spheres[i]) < 0.001f);
+      if(!Frustum_TestAABB(&f.eye[0], &boxes[i]) && !Frustum_TestAABB(&f.eye[1], &boxes[i]))
+        assert(masks[i] == 0 || boundaryDistance(f.eye[0], spheres[i]) < 0.001f || boundaryDistance(f.eye[1], spheres[i]) < 0.001f);
+    }
+  }
+}
+
+static float
+rayAABB(const C3D_AABB &b, const C3D_FVec &o, const C3D_FVec &d)
+{
+  float tmin = 0.0f, tmax = INFINITY;
+  for(size_t i = 0; i < 3; ++i)
+  {
+    // C3D_FVec stores x,y,z at c[3],c[2],c[1]
+    float t0 = (b.min.c[3-i] - o.c[3-i]) / d.c[3-i];
+    float t1 = (b.max.c[3-i] - o.c[3-i]) / d.c[3-i];
+    tmin = std::max(tmin, std::min(t0, t1));
+    tmax = std::min(tmax, std::max(t0, t1));
+  }
+  return tmin <= tmax ? tmin : -1.0f;
+}
+
+static void
+check_bvh_cull(const C3D_BVH &bvh, const std::vector<C3D_AABB> &boxes, const C3D_Frustum &f)
+{
+  std::vector<u32> expected(boxes.size()), visible(boxes.size());
+  int numExpected = Frustum_CullAABBs(&f, boxes.data(), boxes.size(), expected.data(), nullptr);
+  int numVisible  = BVH_CullFrustum(&bvh, &f, visible.data());
+
+  assert(numVisible == numExpected);
+  std::sort(visible.begin(), visible.begin() + numVisible);
+  for(int i = 0; i < numVisible; ++i)
+    assert(visible[i] == expected[i]);
+}
+
+static void
+check_bvh(generator_t &gen, distribution_t &dist)
+{
+  static const int count = 5000;
+
+  std::vector<C3D_AABB> boxes(count);
+  for(size_t i = 0; i < count; ++i)
+  {
+    C3D_FVec c = FVec3_New(dist(gen)*10.0f, dist(gen), dist(gen)*10.0f);
+    C3D_FVec e = FVec3_New(std::abs(dist(gen))*0.05f+0.01f, std::abs(dist(gen))*0.05f+0.01f, std::abs(dist(gen))*0.05f+0.01f);
+    boxes[i].min = FVec3_Subtract(c, e);
+    boxes[i].max = FVec3_Add(c, e);
+  }
+
+  C3D_BVH bvh;
+  assert(BVH_Build(&bvh, boxes.data(), count, 4));
+  assert(bvh.numNodes > 0 && bvh.numNodes < 2*count);
+
+  // every primitive is referenced once and every node bounds its children
+  std::vector<int> refs(count, 0);
+  for(int i = 0; i < bvh.numNodes; ++i)
+  {
+    const C3D_BVHNode &n = bvh.nodes[i];
+    if(n.count)
+    {
+      for(u32 j = 0; j < n.count; ++j)
+        ++refs[bvh.prims[n.index+j]];
+      continue;
+    }
+    const C3D_BVHNode &l = bvh.nodes[i+1], &r = bvh.nodes[n.index];
+    for(size_t j = 0; j < 3; ++j)
+    {
+      assert(n.min[j] <= l.min[j] && n.min[j] <= r.min[j]);
+      assert(n.max[j] >= l.max[j] && n.max[j] >= r.max[j]);
+    }
+  }
+  for(size_t i = 0; i < count; ++i)
+    assert(refs[i] == 1);
+
+  // frustum traversal matches culling the flat list, before and after a refit
+  for(size_t n = 0; n < 20; ++n)
+  {
+    C3D_Mtx proj, view, mvp;
+    Mtx_PerspTilt(&proj, C3D_AngleFromDegrees(60.0f), C3D_AspectRatioTop, 0.1f, 40.0f, false);
+    Mtx_LookAt(&view, FVec3_New(dist(gen)*5.0f, dist(gen), dist(gen)*5.0f), FVec3_New(dist(gen), 0.0f, dist(gen)), FVec3_New(0.0f, 1.0f, 0.0f), false);
+    Mtx_Multiply(&mvp, &proj, &view);
+
+    C3D_Frustum f;
+    Mtx_ExtractFrustum(&f, &mvp);
+    check_bvh_cull(bvh, boxes, f);
+
+    if(n == 10)
+    {
+      for(size_t i = 0; i < count; i += 3)
+      {
+        C3D_FVec d = FVec3_New(dist(gen)*0.1f, dist(gen)*0.1f, dist(gen)*0.1f);
+        boxes[i].min = FVec3_Add(boxes[i].min, d);
+        boxes[i].max = FVec3_Add(boxes[i].max, d);
+      }
+      BVH_Refit(&bvh, boxes.data());
+    }
+  }
+
+  // ray picking finds the nearest box, like testing all of them
+  for(size_t n = 0; n < 200; ++n)
+  {
+    C3D_FVec o = FVec3_New(dist(gen)*10.0f, dist(gen)*2.0f, dist(gen)*10.0f);
+    C3D_FVec d = FVec3_Normalize(FVec3_New(dist(gen), dist(gen)*0.1f, dist(gen)));
+
+    int   expected = -1;
+    float best = 100.0f;
+    for(size_t i = 0; i < count; ++i)
+    {
+      float t = rayAABB(boxes[i], o, d);
+      if(t >= 0.0f && t < best)
+      {
+        best = t;
+        expected = i;
+      }
+    }
+
+    float t = 0.0f;
+    int hit = BVH_Raycast(&bvh, o, d, 100.0f, nullptr, nullptr, &t);
+    assert(hit == expected);
+    if(hit >= 0)
+      assert(std::abs(t - best) < 0.0001f);
+  }
+
+  BVH_Free(&bvh);
+  assert(!bvh.nodes && !bvh.numNodes);
+
+  // leaves hold more primitives than fit 16 bits
+  static const int crowd = 70000;
+  static_assert(sizeof(C3D_BVHNode) == 32, "BVH nodes are 32 bytes");
+  std::vector<C3D_AABB> same(crowd, boxes[0]);
+  assert(BVH_Build(&bvh, same.data(), crowd, crowd));
+  assert(bvh.numNodes == 1 && bvh.nodes[0].count == crowd);
+  BVH_Free(&bvh);
+}
+
+static inline bool
+sameFVec(const C3D_FVec &lhs, const C3D_FVec &rhs)
+{
+  return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z && lhs.w == rhs.w;
+}
+
+static void
+check_transform(generator_t &gen, distribution_t &dist)
+{
+  // Odd count so the vector paths also leave a remainder
+  const int count = 1027;
+
+  for(size_t x = 0; x < 100; ++x)
+  {
+    C3D_Mtx m;
+    for(size_t i = 0; i < 16; ++i)
+      m.m[i] = dist(gen);
+
+    std::vector<C3D_FVec> in(count), out(count);
+    std::vector<float> pts(count*3), xs(count), ys(count), zs(count);
+    for(int i = 0; i < count; ++i)
+    {
+      in[i] = FVec4_New(dist(gen), dist(gen), dist(gen), dist(gen));
+      pts[i*3+0] = xs[i] = in[i].x;
+      pts[i*3+1] = ys[i] = in[i].y;
+      pts[i*3+2] = zs[i] = in[i].z;
+    }
+
+    // The batched kernels must agree exactly with the per-vector functions
+    Mtx_MultiplyFVec4Array(&m, out.data(), in.data(), count);
+    for(int i = 0; i < count; ++i)
+      assert(sameFVec(out[i], Mtx_MultiplyFVec4(&m, in[i])));
+
+    Mtx_MultiplyFVec3Array(&m, out.data(), in.data(), count);
+    for(int i = 0; i < count; ++i)
+      assert(sameFVec(out[i], Mtx_MultiplyFVec3(&m, in[i])));
+
+    // In place
+    out = in;
+    Mtx_MultiplyFVec4Array(&m, out.data(), out.data(), count);
+    for(int i = 0; i < count; ++i)
+      assert(sameFVec(out[i], Mtx_MultiplyFVec4(&m, in[i])));
+
+    Mtx_TransformPointsAffine(&m, pts.data(), pts.data(), count);
+    Mtx_TransformPointsAffineSoA(&m, xs.data(), ys.data(), zs.data(), xs.data(), ys.data(), zs.data(), count);
+    for(int i = 0; i < count; ++i)
+    {
+      C3D_FVec v = Mtx_MultiplyFVecH(&m, in[i]);
+      assert(pts[i*3+0] == v.x && pts[i*3+1] == v.y && pts[i*3+2] == v.z);
+      assert(xs[i] == v.x && ys[i] == v.y && zs[i] == v.z);
+    }
+  }
+}
+
+static inline bool
+nearMtx(const C3D_Mtx &lhs, const C3D_Mtx &rhs, float eps)
+{
+  for(size_t i = 0; i < 16; ++i)
+  {
+    if(std::abs(lhs.m[i] - rhs.m[i]) > eps * std::max(1.0f, std::abs(rhs.m[i])))
+      return false;
+  }
+  return true;
+}
+
+static void
+randomRigid(C3D_Mtx &m, generator_t &gen, distribution_t &dist)
+{
+  Mtx_Identity(&m);
+  Mtx_RotateX(&m, dist(gen), true);
+  Mtx_RotateY(&m, dist(gen), true);
+  Mtx_RotateZ(&m, dist(gen), true);
+  Mtx_Translate(&m, dist(gen), dist(gen), dist(gen), false);
+}
+
+static void
+check_affine(generator_t &gen, distribution_t &dist)
+{
+  for(size_t x = 0; x < 10000; ++x)
+  {
+    C3D_Mtx a, b, r, ref;
+    randomRigid(a, gen, dist);
+    randomRigid(b, gen, dist);
+    Mtx_Scale(&b, dist(gen), dist(gen), dist(gen));
+    assert(Mtx_IsAffine(&a) && Mtx_IsAffine(&b));
+
+    Mtx_MultiplyAffine(&r, &a, &b);
+    Mtx_Multiply(&ref, &a, &b);
+    assert(Mtx_IsAffine(&r));
+    assert(nearMtx(r, ref, 0.0001f));
+
+    // Aliased output
+    r = a;
+    Mtx_MultiplyAffine(&r, &r, &b);
+    assert(nearMtx(r, ref, 0.0001f));
+
+    // Affine inverse against the full inverse
+    r = ref;
+    float det = Mtx_Inverse(&ref);
+    if(std::abs(det) > 0.01f)
+    {
+      assert(std::abs(Mtx_InverseAffine(&r) - det) <= 0.001f * std::max(1.0f, std::abs(det)));
+      assert(Mtx_IsAffine(&r));
+      assert(nearMtx(r, ref, 0.001f));
+    }
+
+    // Rigid inverse against the full inverse
+    r = ref = a;
+    Mtx_Inverse(&ref);
+    Mtx_InverseRigid(&r);
+    assert(Mtx_IsAffine(&r));
+    assert(nearMtx(r, ref, 0.0001f));
+  }
+
+  C3D_Mtx m;
+  Mtx_Identity(&m);
+  m.r[3].x = 1.0f;
+  assert(!Mtx_IsAffine(&m));
+  Mtx_Diagonal(&m, 1.0f, 0.0f, 1.0f, 1.0f);
+  assert(Mtx_InverseAffine(&m) == 0.0f);
+}
+
+static inline bool
+sameRotation(const C3D_FQuat &lhs, const C3D_FQuat &rhs)
+{
+  // q and -q are the same rotation
+  return std::abs(std::abs(Quat_Dot(lhs, rhs)) - 1.0f) < 0.0001f;
+}
+
+static inline C3D_FQuat
+randomRotation(generator_t &gen, distribution_t &dist)
+{
+  return Quat_Normalize(Quat_New(dist(gen), dist(gen), dist(gen), dist(gen)));
+}
+
+static void
+check_anim(generator_t &gen, distribution_t &dist)
+{
+  // slerp matches a*(a^-1*b)^t along the shorter arc
+  for(size_t x = 0; x < 10000; ++x)
+  {
+    C3D_FQuat a = randomRotation(gen, dist);
+    C3D_FQuat b = randomRotation(gen, dist);
+    float     t = std::abs(dist(gen)) / 10.0f;
+
+    assert(sameRotation(Quat_Slerp(a, b, 0.0f), a));
+    assert(sameRotation(Quat_Slerp(a, b, 1.0f), b));
+    assert(sameRotation(Quat_Nlerp(a, b, 0.0f), a));
+    assert(sameRotation(Quat_Nlerp(a, b, 1.0f), b));
+
+    C3D_FQuat d = Quat_Multiply(Quat_Inverse(a), b);
+    if(d.r < 0.0f)
+      d = Quat_Negate(d);
+    if(d.r < 0.999f)
+      assert(sameRotation(Quat_Slerp(a, b, t), Quat_Multiply(a, Quat_Pow(d, t))));
+
+    // nlerp stays on the same arc, at a different rate
+    C3D_FQuat n = Quat_Nlerp(a, b, t);
+    assert(std::abs(FVec4_Magnitude(n) - 1.0f) < 0.0001f);
+    float an = std::acos(std::min(1.0f, std::abs(Quat_Dot(a, n))));
+    float nb = std::acos(std::min(1.0f, std::abs(Quat_Dot(n, b))));
+    float ab = std::acos(std::min(1.0f, std::abs(Quat_Dot(a, b))));
+    assert(std::abs(an + nb - ab) < 0.001f);
+  }
+
+  // track sampling
+  {
+    static const float times[] = { 0.0f, 1.0f, 3.0f };
+    C3D_FQuat rot[3];
+    C3D_FVec  trans[3];
+    for(int i = 0; i < 3; ++i)
+    {
+      rot[i]   = randomRotation(gen, dist);
+      trans[i] = FVec3_New(dist(gen), dist(gen), dist(gen));
+    }
+    C3D_BoneTrack track = { times, rot, trans, 3 };
+    C3D_AnimClip  clip  = { &track, 1, 3.0f };
+    C3D_BonePose  pose, ref;
+
+    for(int i = 0; i < 3; ++i)
+    {
+      Anim_SampleTrack(&track, times[i], &pose);
+      assert(sameRotation(pose.rot, rot[i]));
+      assert(FVec3_Distance(pose.trans, trans[i]) < 0.0001f);
+    }
+
+    Anim_SampleTrack(&track, -1.0f, &pose);
+    assert(sameRotation(pose.rot, rot[0]));
+    Anim_SampleTrack(&track, 4.0f, &pose);
+    assert(sameRotation(pose.rot, rot[2]));
+
+    Anim_SampleTrack(&track, 2.0f, &pose);
+    assert(sameRotation(pose.rot, Quat_Nlerp(rot[1], rot[2], 0.5f)));
+    assert(FVec3_Distance(pose.trans, FVec3_Scale(FVec3_Add(trans[1], trans[2]), 0.5f)) < 0.0001f);
+
+    Anim_SampleClip(&clip, 5.0f, true, &ref);
+    assert(sameRotation(pose.rot, ref.rot));
+    Anim_SampleClip(&clip, -1.0f, true, &ref);
+    assert(sameRotation(pose.rot, ref.rot));
+  }
+
+  // blending
+  {
+    const int numBones = 8;
+    std::vector<C3D_BonePose> a(numBones), b(numBones), out(numBones), ref(numBones);
+    for(int i = 0; i < numBones; ++i)
+    {
+      a[i].rot   = randomRotation(gen, dist);
+      a[i].trans = FVec3_New(dist(gen), dist(gen), dist(gen));
+      b[i].rot   = randomRotation(gen, dist);
+      b[i].trans = FVec3_New(dist(gen), dist(gen), dist(gen));
+    }
+
+    const C3D_BonePose *poses[] = { a.data(), b.data() };
+    float weights[] = { 3.0f, 1.0f };
+    assert(Anim_BlendPoses(out.data(), poses, weights, 2, numBones));
+    Anim_LerpPoses(ref.data(), a.data(), b.data(), 0.25f, numBones);
+    for(int i = 0; i < numBones; ++i)
+    {
+      assert(sameRotation(out[i].rot, ref[i].rot));
+      assert(FVec3_Distance(out[i].trans, ref[i].trans) < 0.0001f);
+    }
+
+    weights[1] = 0.0f;
+    assert(Anim_BlendPoses(out.data(), poses, weights, 2, numBones));
+    for(int i = 0; i < numBones; ++i)
+      assert(sameRotation(out[i].rot, a[i].rot));
+
+    // opposite signs of the same rotation don't cancel out
+    for(int i = 0; i < numBones; ++i)
+    {
+      b[i].rot   = Quat_Negate(a[i].rot);
+      b[i].trans = a[i].trans;
+    }
+    weights[1] = 3.0f;
+    assert(Anim_BlendPoses(out.data(), poses, weights, 2, numBones));
+    for(int i = 0; i < numBones; ++i)
+      assert(sameRotation(out[i].rot, a[i].rot));
+
+    // rotations cancelled out by a negative weight keep the first pose
+    C3D_BonePose        x = { Quat_Identity(), FVec3_New(0.0f, 0.0f, 0.0f) };
+    C3D_BonePose        y = { Quat_New(0.8660254f, 0.0f, 0.0f, 0.5f), x.trans };
+    C3D_BonePose        z = { Quat_New(-0.8660254f, 0.0f, 0.0f, 0.5f), x.trans };
+    const C3D_BonePose *cancel[]        = { &x, &y, &z };
+    float               cancelWeights[] = { -1.0f, 1.0f, 1.0f };
+    assert(Anim_BlendPoses(out.data(), cancel, cancelWeights, 3, 1));
+    assert(sameRotation(out[0].rot, x.rot));
+
+    // degenerate weights leave the output alone
+    C3D_BonePose keep = out[0];
+    weights[0] = 1.0f;
+    weights[1] = -2.0f;
+    assert(!Anim_BlendPoses(out.data(), poses, weights, 2, numBones));
+    assert(!Anim_BlendPoses(out.data(), poses, weights, 0, numBones));
+    assert(std::memcmp(&keep, &out[0], sizeof(keep)) == 0);
+  }
+
+  // palette of a chain against composing the matrices directly
+  {
+    const int numBones = 6;
+    std::vector<C3D_BonePose> pose(numBones);
+    std::vector<C3D_Mtx>      invBind(numBones), world(numBones);
+    std::vector<C3D_FVec>     rows(3*numBones);
+    std::vector<s16>          parent(numBones);
+    for(int i = 0; i < numBones; ++i)
+    {
+      pose[i].rot   = randomRotation(gen, dist);
+      pose[i].trans = FVec3_New(dist(gen), dist(gen), dist(gen));
+      parent[i]     = i - 1 - (i & 1); // roots at 0 and 1
+      Mtx_Identity(&invBind[i]);
+      Mtx_Translate(&invBind[i], dist(gen), dist(gen), dist(gen), true);
+    }
+
+    C3D_Skeleton skel = { parent.data(), invBind.data(), numBones };
+    Anim_ComputePalette(&skel, pose.data(), world.data(), rows.data());
+
+    C3D_Mtx expect[numBones];
+    for(int i = 0; i < numBones; ++i)
+    {
+      C3D_Mtx local;
+      Mtx_FromQuat(&local, pose[i].rot);
+      Mtx_Translate(&local, pose[i].trans.x, pose[i].trans.y, pose[i].trans.z, false);
+      if(parent[i] >= 0)
+        Mtx_Multiply(&expect[i], &expect[parent[i]], &local);
+      else
+        expect[i] = local;
+
+      C3D_Mtx skin;
+      Mtx_Multiply(&skin, &expect[i], &invBind[i]);
+      for(int r = 0; r < 3; ++r)
+        for(int c = 0; c < 4; ++c)
+          assert(std::abs(rows[3*i+r].c[c] - skin.r[r].c[c]) < 0.001f);
+    }
+  }
+}
+
+static void
+check_dualquat(generator_t &gen, distribution_t &dist)
+{
+  for(size_t x = 0; x < 10000; ++x)
+  {
+    C3D_FQuat q = randomRotation(gen, dist);
+    C3D_FVec  t = FVec3_New(dist(gen), dist(gen), dist(gen));
+    C3D_FVec  v = FVec3_New(dist(gen), dist(gen), dist(gen));
+
+    // conversions agree with the equivalent matrix
+    C3D_Mtx m;
+    Mtx_FromQuat(&m, q);
+    Mtx_Translate(&m, t.x, t.y, t.z, false);
+
+    C3D_FDualQuat dq = DualQuat_FromRotTrans(q, t);
+    assert(FVec3_Distance(DualQuat_Translation(dq), t) < 0.001f);
+    assert(FVec3_Distance(DualQuat_TransformFVec3(dq, v), Mtx_MultiplyFVecH(&m, v)) < 0.001f);
+
+    C3D_FDualQuat fm = DualQuat_FromMtx(&m);
+    assert(sameRotation(fm.real, q));
+    assert(FVec3_Distance(DualQuat_TransformFVec3(fm, v), Mtx_MultiplyFVecH(&m, v)) < 0.001f);
+
+    C3D_Mtx back;
+    Mtx_FromDualQuat(&back, dq);
+    assert(nearMtx(back, m, 0.001f));
+
+    // composition matches the matrix product
+    C3D_FQuat     q2  = randomRotation(gen, dist);
+    C3D_FVec      t2  = FVec3_New(dist(gen), dist(gen), dist(gen));
+    C3D_FDualQuat dq2 = DualQuat_FromRotTrans(q2, t2);
+    C3D_Mtx m2, prod;
+    Mtx_FromDualQuat(&m2, dq2);
+    Mtx_Multiply(&prod, &m, &m2);
+    assert(FVec3_Distance(DualQuat_TransformFVec3(DualQuat_Multiply(dq, dq2), v), Mtx_MultiplyFVecH(&prod, v)) < 0.01f);
+
+    // blending with a single weight, or with a negated copy, is the identity operation
+    C3D_FDualQuat pair[2] = { dq, { Quat_Negate(dq.real), Quat_Negate(dq.dual) } };
+    float w[2] = { 0.5f, 0.5f };
+    C3D_FDualQuat b = DualQuat_Blend(pair, w, 2);
+    assert(FVec3_Distance(DualQuat_TransformFVec3(b, v), Mtx_MultiplyFVecH(&m, v)) < 0.001f);
+
+    pair[1] = dq2;
+    w[0] = 1.0f;
+    w[1] = 0.0f;
+    b = DualQuat_Blend(pair, w, 2);
+    assert(FVec3_Distance(DualQuat_TransformFVec3(b, v), Mtx_MultiplyFVecH(&m, v)) < 0.001f);
+
+    // a blended rigid transform stays rigid
+    w[1] = std::abs(dist(gen));
+    b = DualQuat_Blend(pair, w, 2);
+    assert(std::abs(FVec4_Magnitude(b.real) - 1.0f) < 0.0001f);
+    assert(std::abs(Quat_Dot(b.real, b.dual)) < 0.001f);
+  }
+
+  // dual quaternion palette against the matrix palette
+  {
+    const int numBones = 6;
+    std::vector<C3D_BonePose>  pose(numBones);
+    std::vector<C3D_Mtx>       invBind(numBones), world(numBones);
+    std::vector<C3D_FDualQuat> worldDual(numBones), invBindDual(numBones);
+    std::vector<C3D_FVec>      rows(3*numBones), dual(2*numBones);
+    std::vector<s16>           parent(numBones);
+    for(int i = 0; i < numBones; ++i)
+    {
+      pose[i].rot   = randomRotation(gen, dist);
+      pose[i].trans = FVec3_New(dist(gen), dist(gen), dist(gen));
+      parent[i]     = i - 1;
+      Mtx_FromQuat(&invBind[i], randomRotation(gen, dist));
+      Mtx_Translate(&invBind[i], dist(gen), dist(gen), dist(gen), false);
+      invBindDual[i] = DualQuat_FromMtx(&invBind[i]);
+    }
+
+    C3D_Skeleton skel = { parent.data(), invBind.data(), numBones, NULL };
+    Anim_ComputePalette(&skel, pose.data(), world.data(), rows.data());
+    for(int pass = 0; pass < 2; ++pass)
+    {
+      Anim_ComputeDualQuatPalette(&skel, pose.data(), worldDual.data(), dual.data());
+      for(int i = 0; i < numBones; ++i)
+      {
+        C3D_FDualQuat skin = { dual[2*i+0], dual[2*i+1] };
+        C3D_FVec v = FVec3_New(dist(gen), dist(gen), dist(gen));
+        C3D_FVec p = FVec3_New(FVec4_Dot(rows[3*i+0], FVec4_New(v.x, v.y, v.z, 1.0f)),
+                               FVec4_Dot(rows[3*i+1], FVec4_New(v.x, v.y, v.z, 1.0f)),
+                               FVec4_Dot(rows[3*i+2], FVec4_New(v.x, v.y, v.z, 1.0f)));
+        assert(FVec3_Distance(DualQuat_TransformFVec3(skin, v), p) < 0.01f);
+      }
+      skel.invBindDual = invBindDual.data();
+    }
+  }
+}
+
+static inline u32
+legacyF32ToF24(float f)
+{
+  // Reference conversion as done by libctru's f32tof24 for in-range values
+  if(!f)
+    return 0;
+
+  union { float f; u32 u; } v = { f };
+  u32 s   = v.u >> 31;
+  u32 exp = ((v.u >> 23) & 0xFF) - 0x40;
+  u32 man = (v.u >> 7) & 0xFFFF;
+  return man | (exp << 16) | (s << 23);
+}
+
+static void
+check_floatpack(generator_t &gen, distribution_t &dist)
+{
+  std::vector<float> in;
+  static const float special[] = { 0.0f, -0.0f, 1.0f, -1.0f, 1e-30f, -1e-30f, 1e-40f, 1e30f, -1e30f,
+                                   INFINITY, -INFINITY, 65504.0f, 6.1e-5f, 5.9e-8f, 1e19f, 1e-19f };
+  for(float f : special)
+    in.push_back(f);
+
+  std::uniform_int_distribution<u32> bits;
+  for(int i = 0; i < 4093; ++i)
+  {
+    union { u32 u; float f; } v = { bits(gen) };
+    if(std::isnan(v.f))
+      v.f = dist(gen);
+    in.push_back(i & 1 ? v.f : dist(gen));
+  }
+
+  // arrays match the scalar converters bit for bit
+  int count = in.size();
+  std::vector<u32> f24(count), f31(count);
+  std::vector<u16> f16(count);
+  C3D_F32ToF16Array(f16.data(), in.data(), count);
+  C3D_F32ToF24Array(f24.data(), in.data(), count);
+  C3D_F32ToF31Array(f31.data(), in.data(), count);
+  for(int i = 0; i < count; ++i)
+  {
+    assert(f16[i] == C3D_F32ToF16(in[i]));
+    assert(f24[i] == C3D_F32ToF24(in[i]));
+    assert(f31[i] == C3D_F32ToF31(in[i]));
+    assert(!(f16[i] >> 16) && !(f24[i] >> 24) && !(f31[i] >> 31));
+  }
+
+  // values the formats can hold convert like libctru does
+  for(int i = 0; i < 10000; ++i)
+  {
+    float f = dist(gen);
+    assert(C3D_F32ToF24(f) == legacyF32ToF24(f));
+  }
+  assert(C3D_F32ToF24(1.0f) == 0x3F0000);
+  assert(C3D_F32ToF31(1.0f) == 0x1F800000);
+  assert(C3D_F32ToF16(1.0f) == 0x3C00);
+  assert(C3D_F32ToF16(-2.0f) == 0xC000);
+  assert(C3D_F32ToF16(1e10f) == 0x7C00);
+  assert(C3D_F32ToF24(-1e-30f) == 0x800000);
+
+  // fused packing matches the byte layout C3D_ImmSendAttrib used to build
+  int numVecs = count / 4;
+  std::vector<u32> packed(numVecs*3);
+  C3D_PackF24x4Array(packed.data(), in.data(), numVecs);
+  for(int i = 0; i < numVecs; ++i)
+  {
+    u8 bytes[12];
+    for(int c = 0; c < 4; ++c)
+    {
+      u32 v = C3D_F32ToF24(in[i*4+c]);
+      bytes[c*3+0] = v;
+      bytes[c*3+1] = v >> 8;
+      bytes[c*3+2] = v >> 16;
+    }
+
+    u32 words[3];
+    memcpy(words, bytes, sizeof(words));
+    assert(packed[i*3+0] == words[2]);
+    assert(packed[i*3+1] == words[1]);
+    assert(packed[i*3+2] == words[0]);
+  }
+}
+
+static u32
+refLutEntry(float in, float diff)
+{
+  // Scalar packing LightLut_FromArray has always done
+  u32 val = 0;
+  if(in > 0.0f)
+  {
+    in *= 0x1000;
+    val = (in < 0x1000) ? (u32)in : 0xFFF;
+  }
+
+  u32 val2 = 0;
+  if(diff != 0.0f)
+  {
+    if(diff < 0)
+    {
+      diff = -diff;
+      val2 = 0x800;
+    }
+    diff *= 0x800;
+    val2 |= (diff < 0x800) ? (u32)diff : 0x7FF;
+  }
+  return val | (val2 << 12);
+}
+
+static void
+check_lightlut(generator_t &gen, distribution_t &dist)
+{
+  // packing, including values outside the representable range
+  static const float special[] = { 0.0f, -0.0f, 1.0f, -1.0f, 0.99999f, 0.5f, -0.5f, 1e-9f,
+                                   INFINITY, -INFINITY, NAN, -NAN, 2.0f, -2.0f };
+  float data[512];
+  for(int i = 0; i < 512; ++i)
+    data[i] = i < 64 ? special[i % 14] : dist(gen) * 0.15f;
+
+  C3D_LightLut lut;
+  LightLut_FromArray(&lut, data);
+  for(int i = 0; i < 256; ++i)
+    assert(lut.data[i] == refLutEntry(data[i], data[i+256]));
+
+  // shapes match the callback based generator bit for bit
+  static const struct
+  {
+    C3D_LightLutShape shape;
+    C3D_LightLutFunc  func;
+  } shapes[] =
+  {
+    { C3D_LIGHTLUT_PHONG,       powf            },
+    { C3D_LIGHTLUT_SPOT_STEP,   spot_step       },
+    { C3D_LIGHTLUT_SPOT_SMOOTH, spot_smoothstep },
+    { C3D_LIGHTLUT_FRESNEL,     fresnel_schlick },
+    { C3D_LIGHTLUT_GGX,         ggx_distribution },
+    { C3D_LIGHTLUT_BECKMANN,    beckmann_distribution },
+    { C3D_LIGHTLUT_SMITH,       smith_ggx },
+  };
+
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  for(int i = 0; i < 100; ++i)
+  {
+    for(const auto &s : shapes)
+    {
+      float param    = s.shape == C3D_LIGHTLUT_PHONG ? unit(gen) * 64.0f : unit(gen);
+      bool  negative = i & 1;
+
+      C3D_LightLut fast, ref;
+      LightLut_FromShape(&fast, s.shape, param, negative);
+      LightLut_FromFunc(&ref, s.func, param, negative);
+      assert(std::memcmp(fast.data, ref.data, sizeof(fast.data)) == 0);
+    }
+
+    float from = unit(gen), to = from + 1.0f + unit(gen) * 100.0f;
+    float linear = unit(gen), quad = unit(gen) * 0.1f;
+    C3D_LightLutDA fast, ref;
+    LightLutDA_Quadratic(&fast, from, to, linear, quad);
+    LightLutDA_Create(&ref, quadratic_dist_attn, from, to, linear, quad);
+    assert(std::memcmp(fast.lut.data, ref.lut.data, sizeof(fast.lut.data)) == 0);
+    assert(fast.bias == ref.bias && fast.scale == ref.scale);
+  }
+
+  // batches match single tables, distributions peak at N.H = 1
+  C3D_LightLutDesc descs[3] =
+  {
+    { C3D_LIGHTLUT_GGX,      0.3f, false },
+    { C3D_LIGHTLUT_BECKMANN, 0.3f, false },
+    { C3D_LIGHTLUT_SMITH,    0.3f, true  },
+  };
+  C3D_LightLut batch[3];
+  LightLut_FromShapes(batch, descs, 3);
+  for(int i = 0; i < 3; ++i)
+  {
+    LightLut_FromShape(&lut, descs[i].shape, descs[i].param, descs[i].negative);
+    assert(std::memcmp(batch[i].data, lut.data, sizeof(lut.data)) == 0);
+  }
+  for(int i = 0; i < 2; ++i)
+  {
+    for(int j = 1; j < 256; ++j)
+      assert((batch[i].data[j] & 0xFFF) >= (batch[i].data[j-1] & 0xFFF));
+    assert((batch[i].data[255] & 0xFFF) > 0x800);
+  }
+  assert(std::fabs(ggx_distribution(1.0f, 0.3f) - 1.0f) < 1e-6f);
+  assert(beckmann_distribution(1.0f, 0.3f) == 1.0f);
+
+  // rough Beckmann surfaces peak below N.H = 1 and are scaled by that maximum
+  float beckmannPeak = 0.0f;
+  for(int i = 0; i <= 4096; ++i)
+    beckmannPeak = std::max(beckmannPeak, beckmann_distribution(i / 4096.0f, 0.81f));
+  assert(beckmannPeak <= 1.0f + 1e-6f && beckmannPeak > 0.999f);
+  assert(beckmann_distribution(1.0f, 0.81f) < 0.99f);
+  assert(smith_ggx(-0.5f, 0.3f) == 0.0f && smith_ggx(1.0f, 0.3f) == 1.0f);
+
+  // negative tables wrap from x = -1/128 back to x = 0
+  LightLut_FromShape(&lut, C3D_LIGHTLUT_SPOT_STEP, -0.5f, true);
+  assert(lut.data[255] == refLutEntry(1.0f, 0.0f));
+  assert(lut.data[191] == refLutEntry(0.0f, 1.0f));
+
+  // the cache hands out one table per key
+  C3D_LightLut *a = LightLut_Cached(C3D_LIGHTLUT_PHONG, 16.0f, false);
+  C3D_LightLut *b = LightLut_Cached(C3D_LIGHTLUT_PHONG, 16.0f, false);
+  C3D_LightLut *c = LightLut_Cached(C3D_LIGHTLUT_PHONG, 16.0f, true);
+  C3D_LightLut *d = LightLut_Cached(C3D_LIGHTLUT_FRESNEL, 16.0f, false);
+  assert(a && a == b && c && c != a && d && d != a);
+  LightLut_FromShape(&lut, C3D_LIGHTLUT_PHONG, 16.0f, false);
+  assert(std::memcmp(a->data, lut.data, sizeof(lut.data)) == 0);
+
+  // every rewrite of a table gets a new generation
+  u32 generation = lut.generation;
+  LightLut_FromShape(&lut, C3D_LIGHTLUT_PHONG, 16.0f, false);
+  assert(lut.generation != generation && lut.generation != a->generation);
+  generation = lut.generation;
+  LightLut_Changed(&lut);
+  assert(lut.generation != generation);
+
+  for(int i = 0; i < C3D_LIGHTLUT_CACHE_SIZE; ++i)
+    LightLut_Cached(C3D_LIGHTLUT_SPOT_STEP, i / 64.0f, true);
+  assert(!LightLut_Cached(C3D_LIGHTLUT_SPOT_STEP, 1.0f, true));
+  LightLut_CacheClear();
+  assert(LightLut_Cached(C3D_LIGHTLUT_SPOT_STEP, 1.0f, true));
+  LightLut_CacheClear();
+}
+
+static void
+check_lightmodel(generator_t &gen)
+{
+  const u32 white = 0xFF | (0xFF << 10) | (0xFF << 20);
+
+  // one white positional light with every LUT disabled
+  C3D_LightModel m;
+  std::memset(&m, 0, sizeof(m));
+  m.config[0] = 8 << 4; // All LUTs available
+  m.config[1] = ~0u;
+  m.lutAbs    = 0x2222222;
+  m.lights[0].diffuse = white;
+  for(int i = 0; i < 3; ++i)
+    m.lights[0].position[i] = C3D_F32ToF16(i == 2 ? 10.0f : 0.0f);
+
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  for(int i = 0; i < 1000; ++i)
+  {
+    float p[3] = { unit(gen), unit(gen), -2.0f + unit(gen) };
+    float n[3] = { unit(gen), unit(gen), unit(gen) };
+    float nlen = std::sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+    if(nlen < 0.1f)
+      continue;
+
+    float l[3] = { -p[0], -p[1], 10.0f - p[2] };
+    float llen = std::sqrt(l[0]*l[0] + l[1]*l[1] + l[2]*l[2]);
+    float ndl = (n[0]*l[0] + n[1]*l[1] + n[2]*l[2]) / (nlen*llen);
+    float nl  = std::max(0.0f, ndl);
+
+    u32 color;
+    LightModel_Eval(&m, &color, nullptr, &p[0], &p[1], &p[2], &n[0], &n[1], &n[2], 1);
+    assert(std::abs((int)(color & 0xFF) - (int)(nl*255.0f)) <= 1);
+    assert((color & 0xFF) == ((color >> 8) & 0xFF) && (color & 0xFF) == ((color >> 16) & 0xFF));
+    assert((color >> 24) == 0xFF);
+
+    // two-sided diffuse lights back faces too
+    m.lights[0].config = BIT(1);
+    float fn[3] = { -n[0], -n[1], -n[2] };
+    u32 back;
+    LightModel_Eval(&m, &back, nullptr, &p[0], &p[1], &p[2], &fn[0], &fn[1], &fn[2], 1);
+    m.lights[0].config = 0;
+    assert(std::abs((int)(back & 0xFF) - (int)(std::fabs(ndl)*255.0f)) <= 1);
+  }
+
+  // Phong specular through D0, checked against the analytic curve
+  C3D_LightLut phong;
+  LightLut_Phong(&phong, 20.0f);
+  m.luts[0] = &phong;
+  m.config[1] &= ~BIT(16);
+  m.lutAbs &= ~BIT(1); // D0 takes abs(N.H)
+  m.lights[0].diffuse   = 0;
+  m.lights[0].specular0 = white;
+  m.lights[0].config    = BIT(0); // Directional, from +Z
+  for(int i = 0; i < 3; ++i)
+    m.lights[0].position[i] = C3D_F32ToF16(i == 2 ? 1.0f : 0.0f);
+
+  for(int i = 0; i < 100; ++i)
+  {
+    float a = unit(gen) * 0.5f;
+    float p[3] = { 0.0f, 0.0f, -5.0f }, n[3] = { std::sin(a), 0.0f, std::cos(a) };
+    u32 pri, sec;
+    LightModel_Eval(&m, &pri, &sec, &p[0], &p[1], &p[2], &n[0], &n[1], &n[2], 1);
+    float expect = std::pow(std::cos(a), 20.0f) * 255.0f;
+    assert(std::abs((float)(sec & 0xFF) - expect) <= 2.0f);
+    assert((pri & 0xFFFFFF) == 0);
+
+    // without a secondary output the specular is folded into the primary color
+    u32 sum;
+    LightModel_Eval(&m, &sum, nullptr, &p[0], &p[1], &p[2], &n[0], &n[1], &n[2], 1);
+    assert((sum & 0xFF) == (sec & 0xFF));
+  }
+
+  // distance attenuation
+  C3D_LightLutDA da;
+  LightLutDA_Quadratic(&da, 0.0f, 20.0f, 0.1f, 0.05f);
+  m.config[1] &= ~BIT(24);
+  m.config[1] |= BIT(16);
+  m.lights[0].lutDA = &da.lut;
+  m.lights[0].distAttnBias  = C3Di_F32ToFloat(da.bias, 12, 7, 63);
+  m.lights[0].distAttnScale = C3Di_F32ToFloat(da.scale, 12, 7, 63);
+  m.lights[0].diffuse   = white;
+  m.lights[0].specular0 = 0;
+  m.lights[0].config    = 0;
+  for(int i = 0; i < 100; ++i)
+  {
+    float d = (unit(gen) + 1.0f) * 9.0f;
+    float p[3] = { 0.0f, 0.0f, 0.0f }, n[3] = { 0.0f, 0.0f, 1.0f };
+    m.lights[0].position[2] = C3D_F32ToF16(d);
+    float dz = C3Di_FloatToF32(m.lights[0].position[2], 10, 5, 15);
+    u32 color;
+    LightModel_Eval(&m, &color, nullptr, &p[0], &p[1], &p[2], &n[0], &n[1], &n[2], 1);
+    float expect = quadratic_dist_attn(dz, 0.1f, 0.05f) * 255.0f;
+    assert(std::abs((float)(color & 0xFF) - expect) <= 2.0f);
+  }
+}
+
+static void
+passthroughStage(C3D_TexEnv &env)
+{
+  C3D_TexEnvSrc(&env, C3D_Both, 0xF, 0, 0); // GPU_PREVIOUS
+  C3D_TexEnvOp(&env, C3D_Both, 0, 0, 0);
+  C3D_TexEnvFunc(&env, C3D_Both, 0);         // GPU_REPLACE
+  C3D_TexEnvColor(&env, 0xFFFFFFFF);
+  C3D_TexEnvScale(&env, C3D_Both, 0);
+}
+
+static void
+check_texenvmodel(generator_t &gen)
+{
+  std::uniform_int_distribution<u32> color;
+
+  C3D_TexEnvModel m;
+  std::memset(&m, 0, sizeof(m));
+  for(int i = 0; i < 6; ++i)
+  {
+    passthroughStage(m.env[i]);
+    assert(TexEnv_IsPassthrough(&m.env[i]));
+  }
+
+  // stage 0 modulates the vertex color with texture 0, the rest pass it on
+  C3D_TexEnvSrc(&m.env[0], C3D_Both, 0, 3, 0);
+  C3D_TexEnvFunc(&m.env[0], C3D_Both, 1);
+  assert(!TexEnv_IsPassthrough(&m.env[0]));
+
+  for(int i = 0; i < 1000; ++i)
+  {
+    C3D_TexEnvInputs in;
+    std::memset(&in, 0, sizeof(in));
+    in.primary = color(gen);
+    in.tex[0]  = color(gen);
+
+    u32 out;
+    TexEnvModel_Eval(&m, &out, &in, 1);
+    for(int c = 0; c < 32; c += 8)
+      assert(((out >> c) & 0xFF) == ((in.primary >> c) & 0xFF) * ((in.tex[0] >> c) & 0xFF) / 255);
+  }
+
+  // operands, scale and saturation: (1-tex0) + primary alpha, doubled
+  C3D_TexEnvSrc(&m.env[0], C3D_RGB, 3, 0, 0);
+  C3D_TexEnvOp(&m.env[0], C3D_RGB, 1, 2, 0);
+  C3D_TexEnvFunc(&m.env[0], C3D_RGB, 2);
+  C3D_TexEnvScale(&m.env[0], C3D_RGB, 1);
+  for(int i = 0; i < 1000; ++i)
+  {
+    C3D_TexEnvInputs in;
+    std::memset(&in, 0, sizeof(in));
+    in.primary = color(gen);
+    in.tex[0]  = color(gen);
+
+    u32 out;
+    TexEnvModel_Eval(&m, &out, &in, 1);
+    for(int c = 0; c < 24; c += 8)
+    {
+      int v = std::min(255 - (int)((in.tex[0] >> c) & 0xFF) + (int)(in.primary >> 24), 255);
+      assert(((out >> c) & 0xFF) == (u32)std::min(v * 2, 255));
+    }
+    assert((out >> 24) == (in.primary >> 24) * (in.tex[0] >> 24) / 255);
+  }
+
+  // the combiner buffer lags one stage behind: stage 1 still sees the buffer
+  // color, stage 2 what stage 0 wrote
+  std::memset(&m, 0, sizeof(m));
+  for(int i = 0; i < 6; ++i)
+    passthroughStage(m.env[i]);
+  m.bufColor  = 0x80402010;
+  m.bufUpdate = BIT(8) | BIT(12);
+  C3D_TexEnvSrc(&m.env[0], C3D_Both, 0xE, 0, 0); // GPU_CONSTANT
+  C3D_TexEnvColor(&m.env[0], 0x01020304);
+  C3D_TexEnvSrc(&m.env[1], C3D_Both, 0xD, 0, 0); // GPU_PREVIOUS_BUFFER
+  C3D_TexEnvSrc(&m.env[2], C3D_Both, 0xF, 0xD, 0);
+  C3D_TexEnvFunc(&m.env[2], C3D_Both, 2);        // GPU_ADD
+
+  C3D_TexEnvInputs in;
+  std::memset(&in, 0, sizeof(in));
+  u32 out;
+  TexEnvModel_Eval(&m, &out, &in, 1);
+  assert(out == 0x81422314);
+
+  // only the RGB half of the buffer is updated, alpha keeps the buffer color
+  m.bufUpdate = BIT(8);
+  TexEnvModel_Eval(&m, &out, &in, 1);
+  assert(out == 0xFF422314);
+
+  // dot3 of a normal map texel with itself is about one, in every channel
+  std::memset(&m, 0, sizeof(m));
+  for(int i = 0; i < 6; ++i)
+    passthroughStage(m.env[i]);
+  C3D_TexEnvSrc(&m.env[0], C3D_Both, 3, 3, 0);
+  C3D_TexEnvFunc(&m.env[0], C3D_RGB, 7);         // GPU_DOT3_RGBA
+  in.tex[0] = 0xFF80FF80;                        // +Y
+  TexEnvModel_Eval(&m, &out, &in, 1);
+  assert((out & 0xFF) >= 0xFE && out == (out & 0xFF) * 0x01010101u);
+  in.tex[0] = 0xFF808000;                        // -X against +X
+  in.tex[1] = 0xFF8080FF;
+  C3D_TexEnvSrc(&m.env[0], C3D_Both, 3, 4, 0);
+  TexEnvModel_Eval(&m, &out, &in, 1);
+  assert(out == 0);
+}
+
+static void
+check_texenvoptimize(generator_t &gen)
+{
+  std::uniform_int_distribution<u32> color;
+  std::uniform_int_distribution<int> pick(0, 99);
+  static const int srcs[]   = { 0, 1, 2, 3, 4, 0xE, 0xF, 0xF, 0xF };
+  static const int rgbOps[] = { 0, 1, 2, 3, 4, 5, 8, 9, 12, 13 };
+
+  auto choose = [&](const int *list, int count) { return list[pick(gen) % count]; };
+  auto randomSrcs = [&](bool constant) {
+    if(constant)
+      return GPU_TEVSOURCES(0xE, 0xE, 0xE);
+    return GPU_TEVSOURCES(choose(srcs, 9), choose(srcs, 9), choose(srcs, 9));
+  };
+
+  // optimized setups give the same colors with no more active stages
+  for(int i = 0; i < 2000; ++i)
+  {
+    C3D_TexEnvModel m, opt;
+    std::memset(&m, 0, sizeof(m));
+    bool buffer = pick(gen) < 10;
+    for(int k = 0; k < 6; ++k)
+    {
+      C3D_TexEnv &env = m.env[k];
+      passthroughStage(env);
+      if(pick(gen) < 40)
+        continue;
+
+      bool constant = pick(gen) < 20;
+      if(pick(gen) < 70)
+      {
+        C3D_TexEnvSrc(&env, C3D_RGB, 0, 0, 0);
+        env.srcRgb = randomSrcs(constant);
+        C3D_TexEnvOp(&env, C3D_RGB, choose(rgbOps, 10), choose(rgbOps, 10), choose(rgbOps, 10));
+        C3D_TexEnvFunc(&env, C3D_RGB, pick(gen) % 10);
+        C3D_TexEnvScale(&env, C3D_RGB, pick(gen) % 3);
+      }
+      if(pick(gen) < 70)
+      {
+        env.srcAlpha = randomSrcs(constant);
+        C3D_TexEnvOp(&env, C3D_Alpha, pick(gen) % 8, pick(gen) % 8, pick(gen) % 8);
+        C3D_TexEnvFunc(&env, C3D_Alpha, pick(gen) % 10);
+        C3D_TexEnvScale(&env, C3D_Alpha, pick(gen) % 3);
+      }
+      if(buffer && pick(gen) < 30)
+        env.srcRgb = (env.srcRgb & ~0xF) | 0xD;
+      C3D_TexEnvColor(&env, color(gen));
+    }
+    m.bufUpdate = (color(gen) & 0xFF) << 8;
+    m.bufColor  = color(gen);
+
+    opt = m;
+    TexEnv_Optimize(opt.env, m.env);
+
+    int before = 0, after = 0;
+    for(int k = 0; k < 6; ++k)
+    {
+      before += !TexEnv_IsPassthrough(&m.env[k]);
+      after  += !TexEnv_IsPassthrough(&opt.env[k]);
+    }
+    assert(after <= before);
+
+    for(int j = 0; j < 20; ++j)
+    {
+      C3D_TexEnvInputs in;
+      in.primary       = color(gen);
+      in.fragPrimary   = color(gen);
+      in.fragSecondary = color(gen);
+      for(int t = 0; t < 4; ++t)
+        in.tex[t] = color(gen);
+
+      u32 a, b;
+      TexEnvModel_Eval(&m, &a, &in, 1);
+      TexEnvModel_Eval(&opt, &b, &in, 1);
+      assert(a == b);
+    }
+  }
+
+  // a constant stage is folded into the stage reading it, which moves to the front
+  C3D_TexEnv envs[6], opt[6];
+  for(int k = 0; k < 6; ++k)
+    passthroughStage(envs[k]);
+  C3D_TexEnvSrc(&envs[0], C3D_Both, 0xE, 0xE, 0);
+  C3D_TexEnvFunc(&envs[0], C3D_Both, 1); // GPU_MODULATE
+  C3D_TexEnvColor(&envs[0], 0x80808080);
+  C3D_TexEnvSrc(&envs[3], C3D_Both, 0xF, 0, 0);
+  C3D_TexEnvFunc(&envs[3], C3D_Both, 1);
+  TexEnv_Optimize(opt, envs);
+  assert(opt[0].srcRgb == GPU_TEVSOURCES(0xE, 0, 0) && opt[0].funcRgb == 1);
+  assert(opt[0].color == 0x40404040);
+  for(int k = 1; k < 6; ++k)
+    assert(TexEnv_IsPassthrough(&opt[k]));
+
+  // an RGB-only stage and an alpha-only stage share one
+  for(int k = 0; k < 6; ++k)
+    passthroughStage(envs[k]);
+  C3D_TexEnvSrc(&envs[1], C3D_RGB, 3, 0, 0);
+  C3D_TexEnvFunc(&envs[1], C3D_RGB, 1);
+  C3D_TexEnvSrc(&envs[2], C3D_Alpha, 0xF, 3, 0);
+  C3D_TexEnvFunc(&envs[2], C3D_Alpha, 1);
+  TexEnv_Optimize(opt, envs);
+  assert(opt[0].srcRgb == envs[1].srcRgb && opt[0].srcAlpha == envs[2].srcAlpha);
+  for(int k = 1; k < 6; ++k)
+    assert(TexEnv_IsPassthrough(&opt[k]));
+}
+
+static void
+check_lightgrid(generator_t &gen, distribution_t &dist)
+{
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+  C3D_LightGrid grid;
+  assert(!LightGrid_Init(&grid, 0.0f));
+  assert(LightGrid_Init(&grid, 8.0f));
+  for(int i = 0; i < 300; ++i)
+  {
+    C3D_PointLight l;
+    l.pos      = FVec3_New(dist(gen) * 3.0f, dist(gen), dist(gen) * 3.0f);
+    l.radius   = i % 50 == 0 ? 200.0f : i % 37 == 0 ? 0.0f : 1.0f + unit(gen) * 11.0f;
+    l.color[0] = unit(gen);
+    l.color[1] = unit(gen);
+    l.color[2] = unit(gen);
+    l.distAttn = NULL;
+    assert(LightGrid_Add(&grid, &l) == i);
+  }
+  LightGrid_Build(&grid);
+  assert(grid.numBigLights == 6);
+
+  // queries match a brute force pick of the best lights
+  for(int i = 0; i < 500; ++i)
+  {
+    C3D_FVec c = FVec3_New(dist(gen) * 3.0f, dist(gen), dist(gen) * 3.0f);
+    float    h = i % 10 == 0 ? 40.0f : unit(gen) * 3.0f;
+    C3D_AABB box;
+    box.min = FVec3_New(c.x - h, c.y - h, c.z - h);
+    box.max = FVec3_New(c.x + h, c.y + h, c.z + h);
+
+    std::vector<float> ref;
+    for(int j = 0; j < grid.numLights; ++j)
+    {
+      float score = LightGrid_Score(&grid.lights[j], &box);
+      if(score > 0.0f)
+        ref.push_back(score);
+    }
+    std::sort(ref.begin(), ref.end(), std::greater<float>());
+
+    int max = 1 + i % 8;
+    int ids[8];
+    int count = LightGrid_Query(&grid, &box, ids, max);
+    assert(count == std::min<int>(max, ref.size()));
+    for(int k = 0; k < count; ++k)
+    {
+      assert(LightGrid_Score(&grid.lights[ids[k]], &box) == ref[k]);
+      for(int j = 0; j < k; ++j)
+        assert(ids[j] != ids[k]);
+    }
+  }
+
+  // objects next to each other keep the lights they share in the same slot
+  int slotLight[4] = { -1, -1, -1, -1 };
+  u8  slotValid    = 0;
+  int reused       = 0;
+  C3D_FVec c = FVec3_New(-30.0f, 0.0f, 0.0f);
+  for(int i = 0; i < 200; ++i)
+  {
+    C3D_AABB box;
+    box.min = FVec3_New(c.x - 1.0f, c.y - 1.0f, c.z - 1.0f);
+    box.max = FVec3_New(c.x + 1.0f, c.y + 1.0f, c.z + 1.0f);
+    c.x += 0.3f;
+    if(i == 100)
+      slotValid = 0; // as after LightMgr_Build
+
+    int ids[4];
+    int count = LightGrid_Query(&grid, &box, ids, 4);
+
+    int prevLight[4];
+    u8  prevValid = slotValid;
+    std::memcpy(prevLight, slotLight, sizeof(prevLight));
+
+    u8 load;
+    u8 used = LightGrid_AssignSlots(slotLight, slotValid, 4, ids, count, &load);
+    slotValid |= load;
+
+    assert((load & ~used) == 0);
+    int inUse = 0;
+    for(int j = 0; j < 4; ++j)
+    {
+      if(!(used & BIT(j)))
+        continue;
+      ++inUse;
+      assert(std::count(ids, ids + count, slotLight[j]) == 1);
+      if(!(load & BIT(j)))
+      {
+        assert(prevLight[j] == slotLight[j] && (prevValid & BIT(j)));
+        ++reused;
+      }
+    }
+    assert(inUse == count);
+
+    for(int k = 0; k < count; ++k)
+      for(int j = 0; j < 4; ++j)
+        if(prevLight[j] == ids[k] && (prevValid & BIT(j)))
+          assert((used & BIT(j)) && !(load & BIT(j)));
+    if(i == 100)
+      assert(load == used);
+  }
+  assert(reused > 0);
+
+  // lights sharing a distance attenuation table upload it once per slot
+  C3D_LightLutDA da, da2;
+  LightLutDA_Quadratic(&da, 0.0f, 10.0f, 0.1f, 0.01f);
+  LightLutDA_Quadratic(&da2, 0.0f, 20.0f, 0.1f, 0.01f);
+  C3D_PointLight p = grid.lights[1], q = grid.lights[2];
+  p.distAttn = q.distAttn = &da;
+  u32 first  = LightGrid_LoadWords(NULL, &p);
+  u32 second = LightGrid_LoadWords(&da.lut, &q);
+  assert(second == 12 && first == second + 322);
+  q.distAttn = &da2;
+  assert(LightGrid_LoadWords(&da.lut, &q) == first);
+  q.distAttn = NULL;
+  assert(LightGrid_LoadWords(&da.lut, &q) == 8);
+
+  LightGrid_Free(&grid);
+}
+
+static void
+check_renderplan(generator_t &gen)
+{
+  // a pass drawing on an unused transient is culled, and switching between
+  // targets sharing a depth buffer keeps the early depth buffer
+  C3D_RenderPlanRes  res[C3D_RENDERGRAPH_MAX_RESOURCES] = {
+    { 0, 0, 3 }, { 0, 0, 0 }, { 100, -1, 3 }, { 50, -1, 0 } };
+  C3D_RenderPlanPass passes[C3D_RENDERGRAPH_MAX_PASSES] = {
+    { 0, 2 }, { 0, 3 }, { BIT(2), 0 }, { 0, 1 }, { 0, 0 } };
+  C3D_RenderPlan     plan;
+  RenderPlan_Build(&plan, passes, 5, res, 4);
+  assert(plan.numScheduled == 4);
+  assert(plan.order[0] == 0 && plan.order[1] == 2 && plan.order[2] == 4 && plan.order[3] == 3);
+  assert(plan.first[3] < 0 && plan.slot[3] < 0 && plan.numSlots == 1);
+  assert(plan.clearEarly == (BIT(0) | BIT(2)));
+  assert(plan.keepEarlyDepth == BIT(3));
+  passes[3].reads = BIT(0);
+  RenderPlan_Build(&plan, passes, 5, res, 4);
+  assert(plan.order[2] == 3 && plan.order[3] == 4);
+  assert(plan.keepEarlyDepth == BIT(3));
+  passes[4].reads = BIT(1);
+  RenderPlan_Build(&plan, passes, 5, res, 4);
+  assert(plan.keepEarlyDepth == 0);
+
+  std::uniform_int_distribution<int> size(1, 4);
+  for(int n = 0; n < 1000; ++n)
+  {
+    int numRes    = 2 + n % 15;
+    int numPasses = 1 + n % C3D_RENDERGRAPH_MAX_PASSES;
+    for(int i = 0; i < numRes; ++i)
+    {
+      res[i].size       = i < 2 ? 0 : size(gen) * 0x1000;
+      res[i].depthGroup = i < 2 ? 0 : -1;
+      res[i].clearBits  = gen() % 4;
+    }
+    for(int i = 0; i < numPasses; ++i)
+    {
+      passes[i].target = gen() % numRes;
+      passes[i].reads  = (gen() & gen()) & (BIT(numRes) - 1) & ~BIT(passes[i].target);
+    }
+    RenderPlan_Build(&plan, passes, numPasses, res, numRes);
+
+    // exactly the passes contributing to an imported target are scheduled
+    u16 live = 0;
+    for(int i = numPasses - 1; i >= 0; --i)
+    {
+      bool needed = res[passes[i].target].size == 0;
+      for(int j = i + 1; j < numPasses; ++j)
+        if((live & BIT(j)) && (passes[j].reads & BIT(passes[i].target)))
+          needed = true;
+      if(needed)
+        live |= BIT(i);
+    }
+    int pos[C3D_RENDERGRAPH_MAX_PASSES];
+    std::fill(pos, pos + C3D_RENDERGRAPH_MAX_PASSES, -1);
+    for(int k = 0; k < plan.numScheduled; ++k)
+    {
+      assert(live & BIT(plan.order[k]));
+      assert(pos[plan.order[k]] < 0);
+      pos[plan.order[k]] = k;
+    }
+    assert(plan.numScheduled == __builtin_popcount(live));
+
+    // passes touching the same resource keep their submission order
+    for(int i = 0; i < numPasses; ++i)
+      for(int j = i + 1; j < numPasses; ++j)
+      {
+        if(!(live & BIT(i)) || !(live & BIT(j)))
+          continue;
+        const C3D_RenderPlanPass &a = passes[i], &b = passes[j];
+        if(a.target == b.target || (b.reads & BIT(a.target)) || (a.reads & BIT(b.target)))
+          assert(pos[i] < pos[j]);
+      }
+
+    // transients alive at the same time never share a VRAM block
+    for(int i = 0; i < numRes; ++i)
+    {
+      if(res[i].size == 0 || plan.first[i] < 0)
+      {
+        assert(plan.slot[i] < 0);
+        continue;
+      }
+      assert(plan.slot[i] >= 0 && plan.slot[i] < plan.numSlots);
+      assert(plan.slotSize[plan.slot[i]] >= res[i].size);
+      for(int j = 0; j < i; ++j)
+        if(plan.slot[j] == plan.slot[i])
+          assert(plan.last[j] < plan.first[i] || plan.last[i] < plan.first[j]);
+    }
+
+    // every used resource with clear bits is cleared once
+    for(int i = 0; i < numRes; ++i)
+    {
+      int clears = (plan.clearEarly >> i) & 1;
+      for(int k = 0; k < plan.numScheduled; ++k)
+        if(plan.clearAt[k] & BIT(i))
+        {
+          assert(k == plan.first[i]);
+          ++clears;
+        }
+      assert(clears == (plan.first[i] >= 0 && res[i].clearBits ? 1 : 0));
+    }
+  }
+}
+
+static void
+check_foglut(generator_t &gen)
+{
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+  // exponential fog matches the table FogLut_Exp used to build, bit for bit
+  for(int n = 0; n < 300; ++n)
+  {
+    float density  = 0.001f + unit(gen) * 0.5f;
+    float gradient = n % 3 == 0 ? 1.0f : n % 3 == 1 ? 2.0f : 0.5f + unit(gen) * 2.5f;
+    float near     = 0.1f + unit(gen) * 10.0f;
+    float far      = near + 1.0f + unit(gen) * 1000.0f;
+
+    float data[256];
+    for(int i = 0; i <= 128; ++i)
+    {
+      float x   = FogLut_CalcZ(i / 128.0f, near, far);
+      float val = std::exp(-std::pow(density * x, gradient));
+      if(i < 128)
+        data[i] = val;
+      if(i > 0)
+        data[i + 127] = val - data[i - 1];
+    }
+    C3D_FogLut ref, lut;
+    FogLut_FromArray(&ref, data);
+    FogLut_Exp(&lut, density, gradient, near, far);
+    assert(std::memcmp(ref.data, lut.data, sizeof(ref.data)) == 0);
+    if(gradient == 2.0f)
+    {
+      FogLut_Exp2(&lut, density, near, far);
+      assert(std::memcmp(ref.data, lut.data, sizeof(ref.data)) == 0);
+    }
+  }
+
+  // linear fog without a ramp is a step at its start
+  C3D_FogLut lut;
+  FogLut_Linear(&lut, 20.0f, 20.0f, 1.0f, 100.0f);
+  int steps = 0;
+  for(int i = 0; i < 128; ++i)
+  {
+    u32 val = lut.data[i] >> 13;
+    assert(val == 0 || val == 0x7FF);
+    if(i > 0 && val != lut.data[i - 1] >> 13)
+      ++steps;
+    float z = FogLut_CalcZ(i / 128.0f, 1.0f, 100.0f);
+    assert((val != 0) == (z < 20.0f));
+  }
+  assert(steps == 1);
+}
+
 int main(int argc, char *argv[])
 {
   std::random_device rd;
@@ -972,6 +2628,25 @@ int main(int argc, char *argv[])
 
   check_matrix(gen, dist);
   check_quaternion(gen, dist);
+  check_dynres(gen, dist);
+  check_frustum(gen, dist);
+  check_frustum_stereo(gen, dist);
+  check_bvh(gen, dist);
+  check_transform(gen, dist);
+  check_affine(gen, dist);
+  check_anim(gen, dist);
+  check_dualquat(gen, dist);
+  check_floatpack(gen, dist);
+  check_lightlut(gen, dist);
+  check_lightmodel(gen);
+  check_texenvmodel(gen);
+  check_texenvoptimize(gen);
+  check_lightgrid(gen, dist);
+  check_renderplan(gen);
+  check_foglut(gen);
+
+  if(argc > 1 && std::strcmp(argv[1], "bench") == 0)
+    bench_transform(gen, dist);
 
   return EXIT_SUCCESS;
 }